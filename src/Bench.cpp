@@ -0,0 +1,375 @@
+// Benchmark suite: fixed-seed scenarios plus microbenchmarks of the hot
+// steps, reported as JSON on stdout so runs of two versions can be diffed.
+#include "Field.h"
+#include "Organism.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every allocation of the process is counted, so a scenario can report the
+// allocations its ticks make
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+#if !defined(_MSC_VER) // MSVC has no aligned_alloc; its aligned allocations go uncounted
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Keeps a result alive so the timed work is not optimised away
+static volatile uint64_t sink;
+
+struct Scenario {
+    const char* name;
+    int width, height;
+    uint64_t ticks;
+    float fill;          // Share of cells occupied at the start, 0: the usual 50 organisms
+    float carnivorous;   // Share of the initial organisms that are carnivores
+    bool brains;
+};
+
+// Sizes and lengths keep the whole suite around ten seconds on one core
+static const Scenario SCENARIOS[] = {
+    {"sparse", 300, 200, 3000, 0.0f, 0.0f, false},
+    {"carpet", 300, 200, 2000, 1.0f, 0.0f, false},
+    {"carnivores", 300, 200, 1000, 0.5f, 0.4f, false},
+    {"brains", 300, 200, 3000, 0.0f, 0.0f, true},
+    {"large_sparse", 1000, 1000, 4000, 0.0f, 0.0f, false},
+    {"large_carpet", 1000, 1000, 1000, 1.0f, 0.0f, false},
+    {"huge_sparse", 4000, 4000, 1000, 0.0f, 0.0f, false},
+};
+
+// Places organisms on a `fill` share of the cells, in an order fixed by the seed
+static void populate(Field& field, float fill, float carnivorous, uint64_t seed) {
+    CounterRng rng(seed, 0, 0);
+    for (int y = 0; y < field.get_height(); ++y) {
+        for (int x = 0; x < field.get_width(); ++x) {
+            if (fill < 1.0f && !rng.chance(fill)) continue;
+            OrganismType type = rng.chance(carnivorous) ? OrganismType::Carnivorous : OrganismType::Photosynthetic;
+            field.add_organism(x, y, type);
+        }
+    }
+}
+
+static std::unique_ptr<Field> make_field(int width, int height, bool brains, int threads, uint64_t seed) {
+    FieldSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.seed = seed;
+    settings.brains = brains;
+    settings.threads = threads;
+    return std::make_unique<Field>(settings);
+}
+
+static void run_scenario(const Scenario& scenario, double scale, int threads, bool first) {
+    const uint64_t seed = 42;
+    auto field = make_field(scenario.width, scenario.height, scenario.brains, threads, seed);
+    if (scenario.fill > 0.0f) populate(*field, scenario.fill, scenario.carnivorous, seed);
+    const uint64_t ticks = std::max<uint64_t>(1, static_cast<uint64_t>(scenario.ticks * scale));
+    const uint32_t start_population = field->get_organism_count();
+    const uint64_t start_updates = field->get_statistics().get_total_updates();
+
+    const uint64_t start_allocations = allocations.load();
+    auto start = Clock::now();
+    for (uint64_t t = 0; t < ticks; ++t) field->tick();
+    double elapsed = seconds_since(start);
+    const uint64_t allocated = allocations.load() - start_allocations;
+    const uint64_t updates = field->get_statistics().get_total_updates() - start_updates;
+
+    std::cout << (first ? "" : ",\n") << "    {\"name\": \"" << scenario.name << "\", \"width\": " << scenario.width
+              << ", \"height\": " << scenario.height << ", \"ticks\": " << ticks
+              << ", \"start_population\": " << start_population
+              << ", \"end_population\": " << field->get_organism_count() << ", \"seconds\": " << elapsed
+              << ", \"ticks_per_sec\": " << (elapsed > 0.0 ? ticks / elapsed : 0.0)
+              << ", \"organism_updates\": " << updates
+              << ", \"ns_per_update\": " << (updates ? elapsed * 1e9 / updates : 0.0)
+              << ", \"allocations_per_tick\": " << static_cast<double>(allocated) / ticks
+              << ", \"state_hash\": \"" << std::hex << field->state_hash() << std::dec << "\"}";
+}
+
+// Microbenchmarks reach the private steps of an Organism through here
+class Bench {
+public:
+    static bool find_free_direction(const Organism& organism, int& direction) { return organism.find_free_direction(direction); }
+    static void reproduce(Organism& organism) { organism.reproduce(); }
+};
+
+static void report_micro(const char* name, uint64_t calls, double elapsed, bool first) {
+    std::cout << (first ? "" : ",\n") << "    {\"name\": \"" << name << "\", \"calls\": " << calls
+              << ", \"ns_per_call\": " << (calls ? elapsed * 1e9 / calls : 0.0) << "}";
+}
+
+// A mid-run world: a sparse start grown for a while
+static std::unique_ptr<Field> grown_field(int ticks) {
+    auto field = make_field(300, 200, false, 1, 7);
+    for (int t = 0; t < ticks; ++t) field->tick();
+    return field;
+}
+
+static void micro_get_density(double scale, bool first) {
+    auto field = grown_field(1500);
+    std::vector<int> cells;
+    CounterRng rng(1, 0, 0);
+    for (int i = 0; i < 4096; ++i) cells.push_back(field->index_of(rng.next_int(field->get_width()), rng.next_int(field->get_height())));
+    const uint64_t rounds = std::max<uint64_t>(1, static_cast<uint64_t>(2000 * scale));
+    uint64_t sum = 0;
+    auto start = Clock::now();
+    for (uint64_t r = 0; r < rounds; ++r) {
+        for (int index : cells) sum += field->get_density(index);
+    }
+    double elapsed = seconds_since(start);
+    sink = sum;
+    report_micro("get_density", rounds * cells.size(), elapsed, first);
+}
+
+static void micro_find_free_direction(double scale, bool first) {
+    auto field = grown_field(1500);
+    ChangeLog changes;
+    std::vector<OrganismId> ids;
+    for (int y = 0; y < field->get_height(); ++y) {
+        for (int x = 0; x < field->get_width(); ++x) {
+            OrganismId id = field->get_organism(x, y);
+            if (id != NO_ORGANISM) ids.push_back(id);
+        }
+    }
+    const uint64_t rounds = std::max<uint64_t>(1, static_cast<uint64_t>(200 * scale));
+    uint64_t found = 0;
+    auto start = Clock::now();
+    for (uint64_t r = 0; r < rounds; ++r) {
+        for (OrganismId id : ids) {
+            int direction;
+            found += Bench::find_free_direction(Organism(*field, id, changes), direction) ? direction + 1 : 0;
+        }
+    }
+    double elapsed = seconds_since(start);
+    sink = found;
+    report_micro("find_free_direction", rounds * ids.size(), elapsed, first);
+}
+
+static void micro_reproduce(double scale, bool first) {
+    // Fertile parents three cells apart, so every birth finds free cells
+    const uint64_t rounds = std::max<uint64_t>(1, static_cast<uint64_t>(20 * scale));
+    uint64_t calls = 0;
+    double elapsed = 0.0;
+    for (uint64_t r = 0; r < rounds; ++r) {
+        auto field = make_field(300, 200, false, 1, 11 + r);
+        std::vector<OrganismId> parents;
+        for (int y = 1; y < field->get_height(); y += 3) {
+            for (int x = 1; x < field->get_width(); x += 3) {
+                OrganismId id = field->add_organism(x, y, OrganismType::Photosynthetic);
+                if (id == NO_ORGANISM) continue; // One of the initial organisms is there
+                field->get_pool().energy[id] = field->get_rules().max_energy;
+                field->get_pool().age[id] = field->get_rules().fertility_delay;
+                parents.push_back(id);
+            }
+        }
+        field->get_pool().reserve_free(static_cast<uint32_t>(parents.size()));
+        ChangeLog changes;
+        changes.species.reserve(parents.size());
+        auto start = Clock::now();
+        for (OrganismId id : parents) {
+            Organism parent(*field, id, changes);
+            Bench::reproduce(parent);
+        }
+        elapsed += seconds_since(start);
+        calls += parents.size();
+    }
+    report_micro("reproduce", calls, elapsed, first);
+}
+
+static void micro_draw(double scale, bool first) {
+    // One publish per tick, as the viewer's simulation thread does: update
+    // the level of detail, then repaint what changed of a screen-sized view
+    // of the cells and of the whole world zoomed out
+    auto field = make_field(1000, 1000, false, 1, 7);
+    for (int t = 0; t < 1500; ++t) field->tick();
+    const ViewRect views[2] = {{0, 0, 780, 600, 0}, {0, 0, (field->get_width() + 1) / 2, (field->get_height() + 1) / 2, 1}};
+    const char* names[2] = {"Field::draw", "Field::draw zoomed out"};
+    std::vector<uint32_t> images[2];
+    for (int v = 0; v < 2; ++v) images[v].resize(static_cast<size_t>(views[v].width) * views[v].height);
+    field->update_detail(1);
+    const uint64_t ticks = std::max<uint64_t>(1, static_cast<uint64_t>(500 * scale));
+    double update = 0.0, draw[2] = {};
+    for (uint64_t t = 1; t <= ticks; ++t) {
+        field->tick();
+        auto start = Clock::now();
+        field->update_detail(t + 1);
+        update += seconds_since(start);
+        for (int v = 0; v < 2; ++v) {
+            start = Clock::now();
+            field->draw(views[v], images[v].data(), t == 1 ? 0 : t);
+            draw[v] += seconds_since(start);
+        }
+    }
+    sink = images[0][images[0].size() / 2] ^ images[1][images[1].size() / 2];
+    report_micro("Field::update_detail", ticks, update, first);
+    for (int v = 0; v < 2; ++v) report_micro(names[v], ticks, draw[v], false);
+}
+
+static void micro_hunt(double scale, bool first) {
+    // The prey distances from scratch, then brought up to date after each
+    // tick of a grown world, as Field::tick does with hunt_range set
+    FieldSettings settings;
+    settings.width = 1000;
+    settings.height = 1000;
+    settings.seed = 7;
+    settings.rules.hunt_range = 16;
+    Field field(settings);
+    for (int t = 0; t < 1500; ++t) field.tick();
+    HuntMap map;
+    const uint64_t rounds = std::max<uint64_t>(1, static_cast<uint64_t>(20 * scale));
+    double full = 0.0, incremental = 0.0;
+    for (uint64_t r = 0; r < rounds; ++r) {
+        map.reset(field.get_width(), field.get_height(), field.is_wrapping());
+        auto start = Clock::now();
+        map.rebuild(field, nullptr);
+        full += seconds_since(start);
+    }
+    const uint64_t ticks = std::max<uint64_t>(1, static_cast<uint64_t>(200 * scale));
+    for (uint64_t t = 0; t < ticks; ++t) {
+        field.tick();
+        auto start = Clock::now();
+        map.rebuild(field, nullptr);
+        incremental += seconds_since(start);
+    }
+    sink = static_cast<uint64_t>(map.get_distance(500, 500));
+    report_micro("HuntMap::rebuild", rounds, full, first);
+    report_micro("HuntMap::rebuild after a tick", ticks, incremental, false);
+}
+
+static void micro_neural_net(double scale, bool first) {
+    const uint32_t brains = 4096;
+    Brain net;
+    net.resize(brains);
+    CounterRng rng(3, 0, 0);
+    for (uint32_t i = 0; i < brains; ++i) net.randomize(i, rng);
+    const uint64_t rounds = std::max<uint64_t>(1, static_cast<uint64_t>(100 * scale));
+
+    // One brain at a time, as an organism woken mid-tick thinks
+    float total = 0.0f;
+    auto start = Clock::now();
+    for (uint64_t r = 0; r < rounds; ++r) {
+        for (uint32_t i = 0; i < brains; ++i) {
+            BrainOutput output = net.compute(i, make_brain_input(static_cast<float>(i % 100), i % 9, 1.0f, Rules().max_energy));
+            total += output.reproduce;
+        }
+    }
+    report_micro("NeuralNet::compute", rounds * brains, seconds_since(start), first);
+
+    // A block of BRAIN_LANES brains, as Field::think runs them; per brain
+    alignas(32) float energy[BRAIN_LANES], density[BRAIN_LANES];
+    for (int lane = 0; lane < BRAIN_LANES; ++lane) {
+        energy[lane] = 0.1f * lane;
+        density[lane] = lane / 8.0f;
+    }
+    float outputs[BRAIN_OUTPUTS][BRAIN_LANES];
+    start = Clock::now();
+    for (uint64_t r = 0; r < rounds; ++r) {
+        for (uint32_t block = 0; block < brains / BRAIN_LANES; ++block) {
+            net.compute_block(block, energy, density, 1.0f, outputs);
+            total += outputs[0][0];
+        }
+    }
+    report_micro("NeuralNet::compute_block", rounds * brains, seconds_since(start), false);
+    sink = static_cast<uint64_t>(total);
+}
+
+static const char* simd_name() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--scale F] [--threads N] [--only NAME] [--no-micro]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    double scale = 1.0;  // Multiplies every tick and round count
+    int threads = 1;
+    std::string only;    // Run just this scenario or microbenchmark
+    bool micro = true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-micro") == 0) {
+            micro = false;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "{\n  \"brain_gene_bytes\": " << sizeof(Brain::GeneType) << ", \"simd\": \"" << simd_name()
+              << "\", \"threads\": " << threads << ", \"scale\": " << scale << ",\n  \"scenarios\": [\n";
+    bool first = true;
+    for (const Scenario& scenario : SCENARIOS) {
+        if (!only.empty() && only != scenario.name) continue;
+        run_scenario(scenario, scale, threads, first);
+        first = false;
+    }
+    std::cout << "\n  ],\n  \"micro\": [\n";
+    if (micro) {
+        struct Micro {
+            const char* name;
+            void (*run)(double, bool);
+        };
+        static const Micro MICROS[] = {
+            {"get_density", micro_get_density},
+            {"find_free_direction", micro_find_free_direction},
+            {"reproduce", micro_reproduce},
+            {"draw", micro_draw},
+            {"hunt", micro_hunt},
+            {"neural_net", micro_neural_net},
+        };
+        first = true;
+        for (const Micro& m : MICROS) {
+            if (!only.empty() && only != m.name) continue;
+            m.run(scale, first);
+            first = false;
+        }
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "Checkpoint.h"
+#include "Field.h"
+#include <cstdio>
+#include <fstream>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            bytes = static_cast<const uint8_t*>(mapped);
+            length = static_cast<size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+    if (bytes) return true;
+#endif
+    // No mmap: read the whole file instead
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    fallback.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(fallback.data()), static_cast<std::streamsize>(fallback.size()))) {
+        fallback.clear();
+        return false;
+    }
+    bytes = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+void MappedFile::close() {
+#if !defined(_WIN32)
+    if (bytes && fallback.empty()) {
+        munmap(const_cast<uint8_t*>(bytes), length);
+    }
+#endif
+    fallback.clear();
+    bytes = nullptr;
+    length = 0;
+}
+
+bool write_file_atomically(const std::string& path, const std::vector<uint8_t>& bytes, std::string& error) {
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + temp;
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+#if !defined(_WIN32)
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        error = "cannot write " + temp;
+        std::remove(temp.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    std::remove(path.c_str()); // rename() does not replace files here
+#endif
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + temp + " to " + path;
+        return false;
+    }
+    return true;
+}
+
+bool save_checkpoint(const Field& field, const std::string& path, std::string& error) {
+    std::vector<uint8_t> image;
+    field.save_checkpoint(image);
+    return write_file_atomically(path, image, error);
+}
+
+bool load_checkpoint(Field& field, const std::string& path, std::string& error) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return field.load_checkpoint(file.data(), file.size(), error);
+}
+
+CheckpointWriter::CheckpointWriter() : thread(&CheckpointWriter::run, this) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void CheckpointWriter::submit(const std::string& path, std::vector<uint8_t>& image) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending_path = path;
+        pending.swap(image);
+        has_pending = true;
+    }
+    wake.notify_one();
+}
+
+void CheckpointWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !has_pending && !writing; });
+}
+
+uint64_t CheckpointWriter::get_written() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+std::string CheckpointWriter::get_last_error() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_error;
+}
+
+void CheckpointWriter::run() {
+    std::vector<uint8_t> image;
+    std::string path;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return has_pending || stopping; });
+        // Pending images are still written on shutdown
+        if (!has_pending) break;
+        image.swap(pending);
+        path = pending_path;
+        has_pending = false;
+        writing = true;
+
+        lock.unlock();
+        std::string error;
+        bool ok = write_file_atomically(path, image, error);
+        lock.lock();
+
+        writing = false;
+        if (ok) {
+            ++written;
+            last_error.clear();
+        } else {
+            last_error = error;
+        }
+        idle.notify_all();
+    }
+}
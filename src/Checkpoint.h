@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Rules.h"
+
+class Field;
+
+// Checkpoint file layout, version 8. A fixed header is followed by one
+// section per array, each starting on a 64-byte boundary, so a mapped file
+// can be copied straight into the Field's arrays. Organisms are stored
+// densely (ids 0..organism_count-1, in row-major grid order) with one array
+// per OrganismPool field; the grid section holds those ids, or NO_ORGANISM.
+// Brains, when the world has them, take Brain::GENOME_SIZE genes of
+// gene_bytes each per organism, and only load into the same build of Brain.
+// Species are rebuilt on load from each organism's founder markers. The
+// nutrient section, like the grid, is row-major over the cells, and empty
+// unless the environment has nutrients; light is recomputed every tick.
+// The header keeps the world's Rules.
+// Random streams are keyed by (seed, tick, uid), so seed, tick_count, the
+// uids and the spawn counter are the whole RNG state.
+constexpr char CHECKPOINT_MAGIC[8] = {'S', 'W', 'E', 'V', 'O', 'C', 'K', 'P'};
+constexpr uint32_t CHECKPOINT_VERSION = 8;
+constexpr uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304; // Reads back swapped on the other endianness
+constexpr size_t CHECKPOINT_ALIGNMENT = 64;
+
+enum CheckpointSection : int {
+    SECTION_CELLS,
+    SECTION_X,
+    SECTION_Y,
+    SECTION_ENERGY,
+    SECTION_AGE,
+    SECTION_TYPE,
+    SECTION_DIRECTION,
+    SECTION_LAST_TICK,
+    SECTION_DORMANT,
+    SECTION_UID,
+    SECTION_BIRTH_TICK,
+    SECTION_WAKE_TICK,
+    SECTION_COLOR,
+    SECTION_MARKERS,
+    SECTION_FOUNDERS,
+    SECTION_GENOME, // Empty without brains
+    SECTION_NUTRIENTS,
+    SECTION_COUNT
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    int32_t width, height;
+    uint8_t wrap;
+    uint8_t simulating;
+    uint8_t brains;
+    uint8_t gene_bytes; // Size of one brain gene, see BrainGene
+    int8_t vision;      // FieldSettings::vision
+    uint8_t environment; // EnvironmentMode
+    float sun_intensity;
+    Rules rules;
+    uint32_t tick_count;
+    uint32_t organism_count;
+    uint64_t seed;
+    uint64_t spawned;
+    uint64_t total_births, total_deaths, total_kills;
+    struct {
+        uint64_t offset, size; // Bytes from the start of the file
+    } sections[SECTION_COUNT];
+};
+
+// Read-only view of a whole file, memory-mapped where the platform allows
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    std::vector<uint8_t> fallback; // Contents when the file could not be mapped
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Writes through a temporary file and renames it over `path`, so a crash
+// mid-write leaves the previous checkpoint intact
+bool write_file_atomically(const std::string& path, const std::vector<uint8_t>& bytes, std::string& error);
+
+bool save_checkpoint(const Field& field, const std::string& path, std::string& error);
+bool load_checkpoint(Field& field, const std::string& path, std::string& error);
+
+// Writes checkpoint images on its own thread. The caller encodes the image
+// (a copy of the arrays, quick next to a tick) and hands it over; the disk
+// write never holds up the tick loop. If images arrive faster than the disk
+// takes them, only the newest one waiting is kept.
+class CheckpointWriter {
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::string pending_path;
+    std::vector<uint8_t> pending;
+    bool has_pending = false;
+    bool writing = false;
+    bool stopping = false;
+    uint64_t written = 0;
+    std::string last_error;
+    std::thread thread; // Last, so it starts after everything it uses
+
+    void run();
+
+public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    // Takes the contents of `image`, leaving it with a spare buffer to reuse
+    void submit(const std::string& path, std::vector<uint8_t>& image);
+    void wait(); // Until everything submitted is on disk
+    uint64_t get_written();
+    std::string get_last_error();
+};
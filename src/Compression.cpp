@@ -0,0 +1,104 @@
+#include "Compression.h"
+#include <cstring>
+
+constexpr int MIN_MATCH = 4;
+constexpr int HASH_BITS = 14;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t LAST_LITERALS = 5; // Blocks end in literals, as in LZ4
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void write_length(std::vector<uint8_t>& out, size_t length) {
+    // Continues a length that overflowed its token nibble
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void write_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_count,
+                           size_t offset, size_t match_length) {
+    size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4 |
+                                         (match_code < 15 ? match_code : 15));
+    out.push_back(token);
+    if (literal_count >= 15) write_length(out, literal_count - 15);
+    out.insert(out.end(), literals, literals + literal_count);
+    if (match_length == 0) return;
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 15) write_length(out, match_code - 15);
+}
+
+void lz_compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // Position + 1, 0: none
+    size_t anchor = 0; // Start of pending literals
+    size_t pos = 0;
+    const size_t match_limit = size > LAST_LITERALS ? size - LAST_LITERALS : 0;
+    while (pos + MIN_MATCH <= match_limit) {
+        uint32_t value = read32(data + pos);
+        uint32_t& slot = table[hash4(value)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != value) {
+            ++pos;
+            continue;
+        }
+        size_t from = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < match_limit && data[from + length] == data[pos + length]) ++length;
+        write_sequence(out, data + anchor, pos - anchor, pos - from, length);
+        pos += length;
+        anchor = pos;
+    }
+    write_sequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+static bool read_length(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in == end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz_decompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size) {
+    const uint8_t* in = data;
+    const uint8_t* end = data + size;
+    size_t written = 0;
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !read_length(in, end, literal_count)) return false;
+        if (literal_count > static_cast<size_t>(end - in) || literal_count > out_size - written) return false;
+        if (literal_count) std::memcpy(out + written, in, literal_count);
+        in += literal_count;
+        written += literal_count;
+        if (in == end) break; // The last sequence has no match
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !read_length(in, end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > written || length > out_size - written) return false;
+        // Byte by byte: matches may overlap their own output
+        for (size_t i = 0; i < length; ++i, ++written) {
+            out[written] = out[written - offset];
+        }
+    }
+    return written == out_size;
+}
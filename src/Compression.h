@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small LZ77 block codec in the LZ4 block layout: sequences of a token
+// (literal count, match length - 4), literals, and a 16-bit match offset.
+// Fast enough to run per block on a background thread and good on the
+// repetitive byte streams of event logs and keyframes.
+void lz_compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+// Decodes a whole block into exactly `size` bytes; false on malformed input
+bool lz_decompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size);
@@ -0,0 +1,208 @@
+// Ensemble runner: many independent worlds over a grid of rule values and
+// seeds, run side by side, one CSV row per world as it finishes.
+#include "Field.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--sweep RULE=V1,V2,...|RULE=FROM:TO:STEP]... [--seeds N] [--seed N] [--rules FILE]"
+              << " [--ticks N] [--width N] [--height N] [--wrap] [--brains] [--vision LEVEL] [--environment light|nutrients]"
+              << " [--jobs N] [--out FILE]" << std::endl;
+}
+
+struct Sweep {
+    const RuleInfo* rule;
+    std::vector<std::string> values; // As given, parsed per run by set_rule
+};
+
+// "a,b,c" or the inclusive range "from:to:step"
+static bool parse_sweep(const char* text, Sweep& sweep, std::string& error) {
+    const char* equals = std::strchr(text, '=');
+    std::string name = equals ? std::string(text, equals) : std::string(text);
+    sweep.rule = find_rule(name);
+    if (!sweep.rule || !equals) {
+        error = sweep.rule ? "expected " + name + "=values" : "unknown rule " + name;
+        return false;
+    }
+    std::string values = equals + 1;
+    double from, to, step;
+    char end;
+    if (std::sscanf(values.c_str(), "%lf:%lf:%lf%c", &from, &to, &step, &end) == 3) {
+        if (!(step > 0.0) || to < from || (to - from) / step > 100000) {
+            error = "bad range for " + name;
+            return false;
+        }
+        // Index the steps instead of accumulating, so the end is hit exactly
+        for (int64_t i = 0; from + i * step <= to + step * 1e-9; ++i) {
+            char value[32];
+            std::snprintf(value, sizeof(value), "%.9g", from + i * step);
+            sweep.values.push_back(value);
+        }
+    } else {
+        for (size_t start = 0; start <= values.size();) {
+            size_t comma = values.find(',', start);
+            if (comma == std::string::npos) comma = values.size();
+            sweep.values.push_back(values.substr(start, comma - start));
+            start = comma + 1;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    FieldSettings base;
+    uint64_t ticks = 10000;
+    uint64_t seeds = 1; // Worlds per rule combination, seeded base.seed, base.seed + 1, ...
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string out_path;
+    std::vector<Sweep> sweeps;
+    std::string error;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            Sweep sweep;
+            if (!parse_sweep(argv[++i], sweep, error)) {
+                std::cerr << "Bad sweep: " << error << std::endl;
+                return 1;
+            }
+            sweeps.push_back(sweep);
+        } else if (std::strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            seeds = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            base.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            if (!load_rules(argv[++i], base.rules, error)) {
+                std::cerr << "Cannot load rules: " << error << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            base.width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            base.height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--wrap") == 0) {
+            base.wrap = true;
+        } else if (std::strcmp(argv[i], "--brains") == 0) {
+            base.brains = true;
+        } else if (std::strcmp(argv[i], "--vision") == 0 && i + 1 < argc) {
+            base.vision = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--environment") == 0 && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "light") == 0) {
+                base.environment = EnvironmentMode::Light;
+            } else if (std::strcmp(argv[i], "nutrients") == 0) {
+                base.environment = EnvironmentMode::LightAndNutrients;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Every combination of the swept values, the last sweep varying fastest,
+    // each run `seeds` times. Rules are checked before anything starts.
+    std::vector<Rules> combinations(1, base.rules);
+    for (const Sweep& sweep : sweeps) {
+        std::vector<Rules> next;
+        for (const Rules& rules : combinations) {
+            for (const std::string& value : sweep.values) {
+                Rules varied = rules;
+                if (!set_rule(varied, *sweep.rule, value, error)) {
+                    std::cerr << "Bad sweep: " << error << std::endl;
+                    return 1;
+                }
+                next.push_back(varied);
+            }
+        }
+        combinations.swap(next);
+    }
+    for (const Rules& rules : combinations) {
+        if (!validate_rules(rules, error)) {
+            std::cerr << "Bad rules: " << error << std::endl;
+            return 1;
+        }
+    }
+    const uint64_t runs = combinations.size() * seeds;
+    if (runs == 0 || runs > INT32_MAX) {
+        std::cerr << "Nothing to run" << std::endl;
+        return 1;
+    }
+
+    std::FILE* out = out_path.empty() ? stdout : std::fopen(out_path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Cannot create " << out_path << std::endl;
+        return 1;
+    }
+    std::fprintf(out, "run,seed");
+    for (const Sweep& sweep : sweeps) std::fprintf(out, ",%s", sweep.rule->name);
+    std::fprintf(out, ",ticks,seconds,population,photosynthetic,carnivorous,mean_energy,species,births,deaths,kills,state_hash\n");
+    std::fflush(out);
+
+    // One world per job, each single-threaded: runs vary a lot in length
+    // (some die out early), and idle workers simply take the next run
+    using Clock = std::chrono::steady_clock;
+    std::mutex out_mutex;
+    auto run = [&](int index) {
+        FieldSettings settings = base;
+        settings.rules = combinations[index / seeds];
+        settings.seed = base.seed + index % seeds;
+        settings.threads = 1;
+        auto start = Clock::now();
+        Field field(settings);
+        uint64_t t = 0;
+        while (t < ticks && field.get_organism_count() > 0) {
+            field.tick();
+            ++t;
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const Statistics& stats = field.get_statistics();
+        std::string row = std::to_string(index) + "," + std::to_string(settings.seed);
+        char value[64];
+        for (const Sweep& sweep : sweeps) {
+            std::snprintf(value, sizeof(value), ",%.9g", get_rule(settings.rules, *sweep.rule));
+            row += value;
+        }
+        std::snprintf(value, sizeof(value), ",%" PRIu64 ",%.3f,%u,%u,%u", t, seconds, field.get_organism_count(),
+                      stats.get_count(OrganismType::Photosynthetic), stats.get_count(OrganismType::Carnivorous));
+        row += value;
+        std::snprintf(value, sizeof(value), ",%.4f,%u", stats.get_mean_energy(), field.get_species().get_species_count());
+        row += value;
+        std::snprintf(value, sizeof(value), ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%016" PRIx64 "\n", stats.get_total_births(),
+                      stats.get_total_deaths(), stats.get_total_kills(), field.state_hash());
+        row += value;
+
+        std::lock_guard<std::mutex> lock(out_mutex);
+        std::fputs(row.c_str(), out);
+        std::fflush(out); // Rows are readable while the rest still run
+    };
+    auto start = Clock::now();
+    ThreadPool pool(jobs);
+    pool.parallel_for(static_cast<int>(runs), run);
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    bool ok = !std::ferror(out);
+    if (out != stdout) ok &= std::fclose(out) == 0;
+    if (!ok) {
+        std::cerr << "Cannot write " << (out_path.empty() ? "the results" : out_path) << std::endl;
+        return 1;
+    }
+    std::cerr << runs << " runs on " << jobs << " threads in " << elapsed << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "Environment.h"
+#include <algorithm>
+#include <cmath>
+#include "Field.h"
+#include "ThreadPool.h"
+
+constexpr int ENVIRONMENT_ROWS_PER_JOB = 32;
+
+void Environment::reset(int new_width, int new_height, bool new_wrap, EnvironmentMode new_mode) {
+    width = new_width;
+    height = new_height;
+    wrap = new_wrap;
+    mode = new_mode;
+    const size_t cells = static_cast<size_t>(width) * height;
+    latitude.assign(height, 1.0f);
+    light.clear();
+    growth.clear();
+    nutrients.clear();
+    next_nutrients.clear();
+    if (!is_enabled()) return;
+
+    // Brightest at the equator, POLAR_LIGHT at the edges
+    const double pi = 3.14159265358979323846;
+    for (int y = 0; y < height; ++y) {
+        double s = std::sin(pi * (y + 0.5) / height);
+        latitude[y] = static_cast<float>(POLAR_LIGHT + (1.0 - POLAR_LIGHT) * s);
+    }
+    light.assign(cells, 0.0f);
+    growth.assign(cells, 0.0f);
+    if (has_nutrients()) {
+        nutrients.assign(cells, NUTRIENT_LEVEL);
+        next_nutrients.assign(cells, NUTRIENT_LEVEL);
+    }
+}
+
+void Environment::update(const Field& field, ThreadPool* workers) {
+    // Sine of the time of day, NIGHT_LIGHT at midnight and 1 at noon
+    const double pi = 3.14159265358979323846;
+    double phase = static_cast<double>(field.get_tick_count() % DAY_LENGTH) / DAY_LENGTH;
+    double day = NIGHT_LIGHT + (1.0 - NIGHT_LIGHT) * 0.5 * (1.0 - std::cos(2.0 * pi * phase));
+    // Per free neighbour, so a cell's light is (8 - density) * row light
+    float light_per_free_cell = static_cast<float>(field.get_rules().photosynthesis_base_rate * day / 8.0) * field.get_sun_intensity();
+
+    const int jobs = (height + ENVIRONMENT_ROWS_PER_JOB - 1) / ENVIRONMENT_ROWS_PER_JOB;
+    auto job = [&](int i) {
+        update_rows(field, light_per_free_cell, i * ENVIRONMENT_ROWS_PER_JOB,
+                    std::min(height, (i + 1) * ENVIRONMENT_ROWS_PER_JOB));
+    };
+    if (workers) {
+        workers->parallel_for(jobs, job);
+    } else {
+        for (int i = 0; i < jobs; ++i) job(i);
+    }
+    if (has_nutrients()) nutrients.swap(next_nutrients);
+}
+
+void Environment::update_rows(const Field& field, float light_per_free_cell, int y0, int y1) {
+    const Occupancy& occupancy = field.get_occupancy();
+    for (int y = y0; y < y1; ++y) {
+        const size_t row = static_cast<size_t>(y) * width;
+        const uint8_t* density = occupancy.density_row(field.index_of(0, y));
+        float* light_row = &light[row];
+        float* growth_row = &growth[row];
+        const float row_light = light_per_free_cell * latitude[y];
+        for (int x = 0; x < width; ++x) {
+            light_row[x] = row_light * static_cast<float>(8 - density[x]);
+        }
+        if (!has_nutrients()) {
+            std::copy_n(light_row, width, growth_row);
+            continue;
+        }
+
+        // Five-point diffusion with recovery towards NUTRIENT_LEVEL. Without
+        // wrapping the edges reflect, so nothing flows out of the world.
+        const int up_y = y > 0 ? y - 1 : (wrap ? height - 1 : y);
+        const int down_y = y < height - 1 ? y + 1 : (wrap ? 0 : y);
+        const float* here = &nutrients[row];
+        const float* up = &nutrients[static_cast<size_t>(up_y) * width];
+        const float* down = &nutrients[static_cast<size_t>(down_y) * width];
+        float* out = &next_nutrients[row];
+        auto diffuse = [&](int x, float left, float right) {
+            float c = here[x];
+            float flow = (left + right) + (up[x] + down[x]) - 4.0f * c;
+            return c + NUTRIENT_DIFFUSION * flow + NUTRIENT_RECOVERY * (NUTRIENT_LEVEL - c);
+        };
+        if (width > 1) {
+            out[0] = diffuse(0, wrap ? here[width - 1] : here[0], here[1]);
+            for (int x = 1; x < width - 1; ++x) {
+                out[x] = diffuse(x, here[x - 1], here[x + 1]);
+            }
+            out[width - 1] = diffuse(width - 1, here[width - 2], wrap ? here[0] : here[width - 1]);
+        }
+        for (int x = 0; x < width; ++x) {
+            growth_row[x] = light_row[x] * (out[x] / (out[x] + NUTRIENT_HALF_GROWTH));
+        }
+    }
+}
+
+float Environment::harvest(int x, int y) {
+    const size_t index = static_cast<size_t>(y) * width + x;
+    float gain = growth[index];
+    if (has_nutrients()) nutrients[index] = std::max(0.0f, nutrients[index] - gain * NUTRIENT_UPTAKE);
+    return gain;
+}
+
+void Environment::deposit(int x, int y, float amount) {
+    if (has_nutrients()) nutrients[static_cast<size_t>(y) * width + x] += amount;
+}
+
+void Environment::set_nutrients(const float* in) {
+    std::copy_n(in, nutrients.size(), nutrients.data());
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "AlignedAllocator.h"
+
+class Field;
+class ThreadPool;
+
+// What the environment simulates, see FieldSettings::environment
+enum class EnvironmentMode : uint8_t {
+    Off,               // Photosynthesis uses the global sun and local density
+    Light,             // Per-cell light map
+    LightAndNutrients  // Light map plus a diffusing nutrient field
+};
+
+constexpr int DAY_LENGTH = 1000;        // Ticks from one midnight to the next
+constexpr float NIGHT_LIGHT = 0.2f;     // Light at midnight, relative to noon
+constexpr float POLAR_LIGHT = 0.4f;     // Light on the top and bottom rows, relative to the equator
+constexpr float NUTRIENT_LEVEL = 1.0f;  // Initial nutrients, which an empty cell recovers towards
+constexpr float NUTRIENT_RECOVERY = 0.001f;   // Fraction of the gap to NUTRIENT_LEVEL closed per tick
+constexpr float NUTRIENT_DIFFUSION = 0.1f;    // Fraction exchanged with each of the 4 neighbours per tick
+constexpr float NUTRIENT_HALF_GROWTH = 0.5f;  // Nutrients at which growth is half of the light
+constexpr float NUTRIENT_UPTAKE = 0.05f;      // Nutrients used per unit of energy gained
+constexpr float NUTRIENT_PER_DEATH = 2.0f;    // Returned to the cell of an organism that dies
+
+// Dense per-cell fields that photosynthesis reads, updated once per tick
+// before anyone acts. The light map combines the sun, a day/night cycle, a
+// latitude gradient and shading by occupied neighbours; growth is the light
+// scaled by the nutrients of the cell, so a photosynthetic organism gains
+// one lookup's worth of energy. Nutrients diffuse, recover slowly, are used
+// up by growth and returned by deaths.
+//
+// The kernels are row loops without branches or reductions, so they
+// vectorise and give the same results at any vector width. Rows are split
+// into blocks that run in parallel.
+class Environment {
+private:
+    using Grid = std::vector<float, AlignedAllocator<float, 32>>;
+
+    EnvironmentMode mode = EnvironmentMode::Off;
+    int width = 0, height = 0;
+    bool wrap = false;
+    std::vector<float> latitude; // Light of each row, relative to the equator
+    Grid light;
+    Grid growth;
+    Grid nutrients;      // Row-major, width x height; empty without nutrients
+    Grid next_nutrients; // Diffusion target, swapped in after each update
+
+    void update_rows(const Field& field, float row_light, int y0, int y1);
+
+public:
+    void reset(int width, int height, bool wrap, EnvironmentMode mode);
+    void update(const Field& field, ThreadPool* workers);
+
+    EnvironmentMode get_mode() const { return mode; }
+    bool is_enabled() const { return mode != EnvironmentMode::Off; }
+    bool has_nutrients() const { return mode == EnvironmentMode::LightAndNutrients; }
+
+    float get_light(int x, int y) const { return light[static_cast<size_t>(y) * width + x]; }
+    float get_growth(int x, int y) const { return growth[static_cast<size_t>(y) * width + x]; }
+    // Energy a photosynthetic organism at (x, y) gains this tick; uses up
+    // the nutrients that growth takes
+    float harvest(int x, int y);
+    void deposit(int x, int y, float amount);
+
+    // Nutrients as stored in checkpoints, width x height floats
+    const float* get_nutrients() const { return nutrients.data(); }
+    void set_nutrients(const float* in);
+};
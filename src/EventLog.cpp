@@ -0,0 +1,371 @@
+#include "EventLog.h"
+#include "Compression.h"
+#include "Field.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t MAX_BLOCK_BYTES = 256 * 1024; // Raw event bytes per block
+constexpr size_t BATCH_TICKS = 64;             // Ticks handed to the recorder at once
+constexpr size_t BATCH_EVENTS = 65536;
+
+static void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool get_varint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        uint8_t byte = in[pos++];
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+size_t ReplayFrame::neighbor(uint32_t index, int dx, int dy) const {
+    int x = static_cast<int>(index % width) + dx;
+    int y = static_cast<int>(index / width) + dy;
+    if (wrap) {
+        x = (x + width) % width;
+        y = (y + height) % height;
+    }
+    if (x < 0 || x >= width || y < 0 || y >= height) return pixels.size();
+    return static_cast<size_t>(y) * width + x;
+}
+
+void ReplayFrame::apply(EventType type, uint32_t index, int arg) {
+    static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}; // up, right, down, left
+    static const int offsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+    if (index >= pixels.size()) return;
+    size_t target;
+    switch (type) {
+        case EventType::Spawn:
+            pixels[index] = to_pixel(arg == static_cast<int>(OrganismType::Carnivorous) ? CARNIVOROUS_COLOR : PHOTOSYNTHETIC_COLOR);
+            break;
+        case EventType::Move:
+            target = neighbor(index, directions[arg & 3][0], directions[arg & 3][1]);
+            if (target < pixels.size()) {
+                pixels[target] = pixels[index];
+                pixels[index] = BACKGROUND_PIXEL;
+            }
+            break;
+        case EventType::Kill:
+            target = neighbor(index, directions[arg & 3][0], directions[arg & 3][1]);
+            if (target < pixels.size()) pixels[target] = BACKGROUND_PIXEL;
+            break;
+        case EventType::Birth:
+            target = neighbor(index, offsets[arg & 7][0], offsets[arg & 7][1]);
+            if (target < pixels.size()) pixels[target] = pixels[index];
+            break;
+        case EventType::Mutation:
+            pixels[index] = to_pixel(CARNIVOROUS_COLOR);
+            break;
+        case EventType::Death:
+            pixels[index] = BACKGROUND_PIXEL;
+            break;
+    }
+}
+
+bool EventRecorder::start(const std::string& path, const Field& field, std::string& error, uint32_t interval) {
+    stop();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    EventLogHeader header = {};
+    std::memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.version = EVENT_LOG_VERSION;
+    header.width = field.get_width();
+    header.height = field.get_height();
+    header.wrap = field.is_wrapping();
+    header.keyframe_interval = std::max(1u, interval);
+    header.seed = field.get_seed();
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    // The run starts from a keyframe of the world as it is
+    frame.width = field.get_width();
+    frame.height = field.get_height();
+    frame.wrap = field.is_wrapping();
+    frame.tick = field.get_tick_count();
+    frame.pixels.assign(static_cast<size_t>(frame.width) * frame.height, BACKGROUND_PIXEL);
+    const OrganismPool& pool = field.get_pool();
+    for (int y = 0; y < frame.height; ++y) {
+        for (int x = 0; x < frame.width; ++x) {
+            OrganismId id = field.cell(field.index_of(x, y));
+            if (id < BORDER_CELL) frame.pixels[static_cast<size_t>(y) * frame.width + x] = to_pixel(pool.color[id]);
+        }
+    }
+    keyframe_interval = header.keyframe_interval;
+    last_error.clear();
+    write_block(BlockKind::Keyframe, frame.tick, frame.tick, reinterpret_cast<const uint8_t*>(frame.pixels.data()),
+                frame.pixels.size() * sizeof(uint32_t));
+    if (!last_error.empty()) {
+        error = last_error;
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    block_open = false;
+    stopping = false;
+    thread = std::thread(&EventRecorder::run, this);
+    return true;
+}
+
+void EventRecorder::append(uint32_t tick, Field& field) {
+    field.take_events(incoming);
+    batch.ticks.push_back(tick);
+    batch.counts.push_back(static_cast<uint32_t>(incoming.size()));
+    batch.events.insert(batch.events.end(), incoming.begin(), incoming.end());
+    if (batch.ticks.size() >= BATCH_TICKS || batch.events.size() >= BATCH_EVENTS) {
+        submit();
+    }
+}
+
+void EventRecorder::submit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(batch));
+    if (spare.empty()) {
+        batch = Batch();
+    } else {
+        batch = std::move(spare.back());
+        spare.pop_back();
+    }
+    wake.notify_one();
+}
+
+void EventRecorder::stop() {
+    if (!thread.joinable()) return;
+    if (!batch.ticks.empty()) submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+std::string EventRecorder::get_last_error() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_error;
+}
+
+void EventRecorder::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return !queue.empty() || stopping; });
+        if (queue.empty()) break; // Stopping, and everything is written
+        Batch work = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        size_t offset = 0;
+        for (size_t i = 0; i < work.ticks.size(); ++i) {
+            encode(work.ticks[i], work.events.data() + offset, work.counts[i]);
+            offset += work.counts[i];
+        }
+        work.ticks.clear();
+        work.counts.clear();
+        work.events.clear();
+
+        lock.lock();
+        spare.push_back(std::move(work));
+    }
+    lock.unlock();
+    flush_block();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void EventRecorder::encode(uint32_t tick, const Event* events, uint32_t count) {
+    if (!block_open) {
+        block.clear();
+        block_first = block_tick = tick;
+        block_index = 0;
+        block_open = true;
+    }
+    put_varint(block, tick - block_tick);
+    put_varint(block, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Event& event = events[i];
+        int64_t index = static_cast<int64_t>(event.y) * frame.width + event.x;
+        block.push_back(static_cast<uint8_t>(static_cast<uint8_t>(event.type) | (event.arg << 3)));
+        put_varint(block, zigzag(index - block_index));
+        block_index = index;
+        frame.apply(event.type, static_cast<uint32_t>(index), event.arg);
+    }
+    block_tick = block_last = frame.tick = tick;
+
+    if (tick % keyframe_interval == 0) {
+        flush_block();
+        write_block(BlockKind::Keyframe, tick, tick, reinterpret_cast<const uint8_t*>(frame.pixels.data()),
+                    frame.pixels.size() * sizeof(uint32_t));
+    } else if (block.size() >= MAX_BLOCK_BYTES) {
+        flush_block();
+    }
+}
+
+void EventRecorder::flush_block() {
+    if (!block_open) return;
+    write_block(BlockKind::Events, block_first, block_last, block.data(), block.size());
+    block_open = false;
+}
+
+void EventRecorder::write_block(BlockKind kind, uint32_t first_tick, uint32_t last_tick, const uint8_t* raw, size_t size) {
+    lz_compress(raw, size, compressed);
+    BlockHeader header = {};
+    header.kind = kind;
+    header.first_tick = first_tick;
+    header.last_tick = last_tick;
+    header.raw_size = static_cast<uint32_t>(size);
+    header.compressed_size = static_cast<uint32_t>(compressed.size());
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(compressed.data(), 1, compressed.size(), file) == compressed.size() &&
+              std::fflush(file) == 0;
+    if (!ok) {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_error = "cannot write the event log";
+    }
+}
+
+bool EventLogReader::open(const std::string& path, std::string& error) {
+    blocks.clear();
+    keyframes.clear();
+    if (!file.open(path)) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (file.size() < sizeof(header)) {
+        error = "event log is truncated";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not an event log";
+        return false;
+    }
+    if (header.version != EVENT_LOG_VERSION) {
+        error = "unsupported event log version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.width <= 0 || header.height <= 0 || header.width > (1 << 16) || header.height > (1 << 16)) {
+        error = "event log has an invalid world size";
+        return false;
+    }
+    const uint64_t frame_bytes = uint64_t(header.width) * header.height * sizeof(uint32_t);
+
+    // Index the blocks; a partly written last block is left out
+    size_t pos = sizeof(header);
+    while (pos + sizeof(BlockHeader) <= file.size()) {
+        BlockHeader block;
+        std::memcpy(&block, file.data() + pos, sizeof(block));
+        size_t payload = pos + sizeof(block);
+        if (block.compressed_size > file.size() - payload) break;
+        if (block.kind == BlockKind::Keyframe ? block.raw_size != frame_bytes : block.kind != BlockKind::Events) break;
+        if (block.kind == BlockKind::Keyframe) keyframes.push_back(blocks.size());
+        blocks.push_back({block.kind, block.first_tick, block.last_tick, payload, block.raw_size, block.compressed_size});
+        pos = payload + block.compressed_size;
+    }
+    if (keyframes.empty() || keyframes.front() != 0) {
+        error = "event log does not start with a keyframe";
+        return false;
+    }
+
+    frame.width = header.width;
+    frame.height = header.height;
+    frame.wrap = header.wrap != 0;
+    if (!load_keyframe(0)) {
+        error = "event log is corrupt";
+        return false;
+    }
+    return true;
+}
+
+bool EventLogReader::load_keyframe(size_t index) {
+    const BlockInfo& block = blocks[index];
+    frame.pixels.resize(static_cast<size_t>(frame.width) * frame.height);
+    if (!lz_decompress(file.data() + block.offset, block.compressed_size,
+                       reinterpret_cast<uint8_t*>(frame.pixels.data()), block.raw_size)) {
+        return false;
+    }
+    frame.tick = block.first_tick;
+    next_block = index + 1;
+    decoded.clear();
+    decoded_pos = 0;
+    return true;
+}
+
+bool EventLogReader::load_events(size_t index) {
+    const BlockInfo& block = blocks[index];
+    decoded.resize(block.raw_size);
+    if (!lz_decompress(file.data() + block.offset, block.compressed_size, decoded.data(), block.raw_size)) {
+        decoded.clear();
+        return false;
+    }
+    decoded_pos = 0;
+    decoded_tick = block.first_tick;
+    decoded_index = 0;
+    return true;
+}
+
+bool EventLogReader::seek(uint32_t tick) {
+    if (blocks.empty()) return false;
+    tick = std::max(get_first_tick(), std::min(tick, get_last_tick()));
+    // Start over from the last keyframe at or before `tick`, unless moving
+    // forward from the current position is no longer than that
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+                               [this](uint32_t t, size_t block) { return t < blocks[block].first_tick; });
+    size_t keyframe = *(it - 1);
+    if (tick < frame.tick || blocks[keyframe].first_tick > frame.tick) {
+        if (!load_keyframe(keyframe)) return false;
+    }
+    return advance(tick);
+}
+
+bool EventLogReader::advance(uint32_t target) {
+    while (frame.tick < target) {
+        if (decoded_pos >= decoded.size()) {
+            if (next_block >= blocks.size()) return true; // End of the log
+            const BlockInfo& block = blocks[next_block];
+            if (block.kind == BlockKind::Keyframe) {
+                if (block.first_tick > target) return true;
+                if (!load_keyframe(next_block)) return false;
+                continue;
+            }
+            if (!load_events(next_block++)) return false;
+            continue;
+        }
+
+        // Peek at the next tick; it stays unread if it lies past the target
+        size_t pos = decoded_pos;
+        uint64_t delta, count;
+        if (!get_varint(decoded, pos, delta) || !get_varint(decoded, pos, count)) return false;
+        uint32_t tick = decoded_tick + static_cast<uint32_t>(delta);
+        if (tick > target) return true;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (pos >= decoded.size()) return false;
+            uint8_t code = decoded[pos++];
+            uint64_t step;
+            if (!get_varint(decoded, pos, step)) return false;
+            decoded_index += unzigzag(step);
+            if ((code & 7) > static_cast<int>(EventType::Death) || decoded_index < 0) return false;
+            frame.apply(static_cast<EventType>(code & 7), static_cast<uint32_t>(decoded_index), code >> 3);
+        }
+        decoded_pos = pos;
+        decoded_tick = frame.tick = tick;
+    }
+    return true;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Checkpoint.h"
+#include "Events.h"
+
+class Field;
+
+// Event log layout, version 1: a header, then self-delimiting blocks, each
+// compressed with lz_compress. Event blocks hold consecutive ticks: per tick
+// a varint tick delta and event count, then per event one byte (type in the
+// low 3 bits, arg above) and the zigzag varint delta of its cell index from
+// the previous event. Keyframe blocks hold the whole picture after a tick,
+// one ARGB pixel per cell. A log cut short by a crash stays readable up to
+// its last complete block.
+constexpr char EVENT_LOG_MAGIC[8] = {'S', 'W', 'E', 'V', 'O', 'L', 'O', 'G'};
+constexpr uint32_t EVENT_LOG_VERSION = 1;
+constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 1000; // Ticks
+
+struct EventLogHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t width, height;
+    uint8_t wrap;
+    uint8_t reserved[3];
+    uint32_t keyframe_interval;
+    uint64_t seed;
+};
+
+enum class BlockKind : uint8_t { Events, Keyframe };
+
+struct BlockHeader {
+    BlockKind kind;
+    uint8_t reserved[3];
+    uint32_t first_tick, last_tick;
+    uint32_t raw_size, compressed_size;
+};
+
+// The picture a replay works on: one ARGB pixel per cell, BACKGROUND_PIXEL
+// where empty. Events are applied in recorded order.
+struct ReplayFrame {
+    int width = 0, height = 0;
+    bool wrap = false;
+    uint32_t tick = 0;
+    std::vector<uint32_t> pixels;
+
+    void apply(EventType type, uint32_t index, int arg);
+    size_t neighbor(uint32_t index, int dx, int dy) const;
+};
+
+// Records a running Field. The simulation thread hands over each tick's
+// events; encoding, compression, keyframes and the disk all happen on the
+// recorder's own thread, which replays the events onto its own frame to
+// produce the keyframes.
+class EventRecorder {
+private:
+    struct Batch {
+        std::vector<uint32_t> ticks;
+        std::vector<uint32_t> counts; // Events per tick
+        std::vector<Event> events;
+    };
+
+    // Simulation thread
+    Batch batch;
+
+    std::vector<Event> incoming; // Swapped with the Field's buffer
+
+    // Shared
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Batch> queue;
+    std::vector<Batch> spare; // Drained batches, kept for their capacity
+    bool stopping = false;
+    std::string last_error;
+
+    // Recorder thread
+    std::FILE* file = nullptr;
+    ReplayFrame frame;
+    uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
+    std::vector<uint8_t> block;      // Raw event block being filled
+    std::vector<uint8_t> compressed;
+    uint32_t block_first = 0, block_last = 0, block_tick = 0;
+    int64_t block_index = 0;
+    bool block_open = false;
+    std::thread thread;
+
+    void run();
+    void encode(uint32_t tick, const Event* events, uint32_t count);
+    void flush_block();
+    void write_block(BlockKind kind, uint32_t first_tick, uint32_t last_tick, const uint8_t* raw, size_t size);
+    void submit();
+
+public:
+    EventRecorder() = default;
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+    ~EventRecorder() { stop(); }
+
+    // Writes the header and a keyframe of the field as it is now. The caller
+    // turns recording on in the field, and off again after stop().
+    bool start(const std::string& path, const Field& field, std::string& error,
+               uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+    // Takes the events gathered since the last call, all up to the end of `tick`
+    void append(uint32_t tick, Field& field);
+    // Writes out everything pending and closes the file
+    void stop();
+    bool is_recording() const { return thread.joinable(); }
+    std::string get_last_error();
+};
+
+// Random access into a recorded run: seek() restores the picture after any
+// tick from the nearest keyframe and the events after it, without running
+// the simulation. Moving forward continues from the current position.
+class EventLogReader {
+private:
+    struct BlockInfo {
+        BlockKind kind;
+        uint32_t first_tick, last_tick;
+        size_t offset; // Of the compressed payload
+        uint32_t raw_size, compressed_size;
+    };
+
+    MappedFile file;
+    EventLogHeader header = {};
+    std::vector<BlockInfo> blocks;
+    std::vector<size_t> keyframes; // Block indices, in tick order
+    ReplayFrame frame;
+
+    // Position in the event stream after `frame.tick`
+    size_t next_block = 0;
+    std::vector<uint8_t> decoded; // Current event block
+    size_t decoded_pos = 0;
+    uint32_t decoded_tick = 0;
+    int64_t decoded_index = 0;
+
+    bool load_keyframe(size_t block);
+    bool load_events(size_t block);
+    bool advance(uint32_t tick);
+
+public:
+    bool open(const std::string& path, std::string& error);
+    bool seek(uint32_t tick);
+    const ReplayFrame& get_frame() const { return frame; }
+    uint32_t get_first_tick() const { return blocks.empty() ? 0 : blocks.front().first_tick; }
+    uint32_t get_last_tick() const { return blocks.empty() ? 0 : blocks.back().last_tick; }
+    uint64_t get_seed() const { return header.seed; }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Species.h"
+#include "Statistics.h"
+
+// Changes to the picture of the world, as recorded for replays. Every event
+// names a cell; `arg` carries whatever else the replay needs to apply it.
+enum class EventType : uint8_t {
+    Spawn,    // Organism placed by hand or at start; arg: OrganismType
+    Move,     // Organism steps to a neighbour; arg: direction (0: up, 1: right, 2: down, 3: left)
+    Kill,     // Attacker at the cell eats the neighbour; arg: direction
+    Birth,    // Parent at the cell gets a child; arg: neighbour (Field's neighbour order)
+    Mutation, // Organism turns carnivorous
+    Death     // Organism starves
+};
+
+struct Event {
+    uint16_t x, y;
+    EventType type;
+    uint8_t arg;
+};
+
+// What one tile changed during a tick. Workers fill their own tile's log
+// and Field merges the logs after each phase in tile order, so statistics,
+// species and events come out the same for any thread count.
+struct ChangeLog {
+    StatsDelta stats;
+    std::vector<SpeciesDelta> species;
+    std::vector<Event> events;
+    bool recording = false; // Events are only kept while a recorder listens
+
+    void record(EventType type, int x, int y, int arg = 0) {
+        if (recording) {
+            events.push_back({static_cast<uint16_t>(x), static_cast<uint16_t>(y), type, static_cast<uint8_t>(arg)});
+        }
+    }
+};
@@ -0,0 +1,19 @@
+#include "Evolution.h"
+
+void Evo::HighView(Organism *Bot) {
+  // Each direction's strip is four table lookups, whatever the radius
+  const int radius = vision_radius(level);
+  const bool hunting = Bot->get_type() == OrganismType::Carnivorous;
+  int best_direction = Bot->get_direction();
+  uint32_t best = 0;
+  for (int i = 0; i < 4; ++i) {
+    int direction = (Bot->get_direction() + i) % 4; // Current heading first
+    Sight sight = Bot->look_ahead(direction, radius);
+    uint32_t score = hunting ? sight.photosynthetic : sight.free_cells();
+    if (i == 0 || score > best) {
+      best = score;
+      best_direction = direction;
+    }
+  }
+  Bot->face(best_direction);
+}
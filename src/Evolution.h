@@ -1,13 +1,18 @@
 #pragma once
 #include "Organism.h"
 
+// Abilities an organism gains on top of the fixed rules. The level decides
+// how far HighView reaches: vision_radius(level) cells.
 class Evo {
 
 private:
   int level; // 0, 1, 2, 3, 4 etc;
 
 public:
+  explicit Evo(int level = 0) : level(level) {}
   void LevelUp(Organism *Bot);
+  // Turns Bot towards what it looks for within sight: prey for a carnivore,
+  // free space for a photosynthetic organism. Keeps its heading on a tie.
   void HighView(Organism *Bot);
   void GiveAbility(Organism *Bot);
   int GetLevel(Organism *Bot);
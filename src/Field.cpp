@@ -1,112 +1,779 @@
 #include "Field.h"
 #include "Organism.h"
-#include <cstdlib>
+#include "Checkpoint.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 
-Field::Field(SDL_Renderer* renderer) : renderer(renderer), sun_intensity(1.0f) {
-    cells.resize(FIELD_WIDTH, std::vector<Organism*>(FIELD_HEIGHT, nullptr));
+// Random stream of the world itself (initial placement), apart from any uid
+constexpr uint64_t WORLD_STREAM = ~0ull;
 
-    // Spawn initial organisms
-    for (int i = 0; i < 50; ++i) {
-        int x = rand() % FIELD_WIDTH;
-        int y = rand() % FIELD_HEIGHT;
-        if (!cells[x][y]) {
-            cells[x][y] = new Organism(x, y, OrganismType::Photosynthetic);
-        }
+Field::Field(const FieldSettings& settings) : rules(settings.rules), seed(settings.seed), sun_intensity(1.0f) {
+    configure(settings.width, settings.height, settings.wrap);
+    if (settings.threads > 1) {
+        workers = std::make_unique<ThreadPool>(settings.threads);
+    }
+    organisms.enable_brains(settings.brains);
+    vision_level = std::max(-1, std::min(settings.vision, VISION_LEVELS - 1));
+    environment.reset(width, height, wrap, settings.environment);
+    spawn_initial();
+}
+
+void Field::configure(int new_width, int new_height, bool new_wrap) {
+    static const int offsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+    static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}; // up, right, down, left
+    width = std::max(2 * GRID_PADDING, new_width);
+    height = std::max(2 * GRID_PADDING, new_height);
+    stride = width + 2 * GRID_PADDING;
+    wrap = new_wrap;
+    for (int i = 0; i < 8; ++i) {
+        neighbor_offsets[i] = offsets[i][1] * stride + offsets[i][0];
     }
+    for (int i = 0; i < 4; ++i) {
+        direction_offsets[i] = directions[i][1] * stride + directions[i][0];
+    }
+    reset_grid();
+    build_tiles();
+    detail.reset(width, height);
+    vision.reset(width, height, wrap);
+    hunt.reset(width, height, wrap);
+    environment.reset(width, height, wrap, environment.get_mode());
 }
 
-Field::~Field() {
-    for (auto& row : cells) {
-        for (auto& organism : row) {
-            delete organism;
+// Splits `extent` cells into `count` spans starting on multiples of `align`
+static std::vector<int> split_extent(int extent, int count, int align) {
+    std::vector<int> bounds;
+    for (int i = 0; i < count; ++i) {
+        bounds.push_back(static_cast<int>(static_cast<int64_t>(i) * extent / count / align * align));
+    }
+    bounds.push_back(extent);
+    return bounds;
+}
+
+// Colour of tile `index` out of `count` in one dimension. Alternating colours
+// keep same-colour tiles a full tile apart; across the seam of a wrapping
+// world an odd count needs a third colour for the last tile.
+static int tile_color(int index, int count, bool wrap) {
+    if (wrap && count > 1 && count % 2 == 1 && index == count - 1) return 2;
+    return index % 2;
+}
+
+void Field::build_tiles() {
+    int columns = std::max(1, width / TILE_WIDTH);
+    int rows = std::max(1, height / TILE_HEIGHT);
+    std::vector<int> xs = split_extent(width, columns, 64);
+    std::vector<int> ys = split_extent(height, rows, 1);
+
+    tile_columns = columns;
+    column_tile.assign((width + 63) / 64, 0);
+    row_tile.assign(height, 0);
+    for (int tx = 0; tx < columns; ++tx) {
+        std::fill(column_tile.begin() + xs[tx] / 64, column_tile.begin() + (xs[tx + 1] + 63) / 64, tx);
+    }
+    for (int ty = 0; ty < rows; ++ty) {
+        std::fill(row_tile.begin() + ys[ty], row_tile.begin() + ys[ty + 1], ty);
+    }
+    wake_timers.assign(static_cast<size_t>(columns) * rows, {});
+    tile_changes.assign(static_cast<size_t>(columns) * rows, ChangeLog());
+    for (ChangeLog& changes : tile_changes) changes.recording = recording;
+
+    phases.assign(9, {});
+    for (int ty = 0; ty < rows; ++ty) {
+        for (int tx = 0; tx < columns; ++tx) {
+            int phase = tile_color(ty, rows, wrap) * 3 + tile_color(tx, columns, wrap);
+            phases[phase].push_back({xs[tx], ys[ty], xs[tx + 1], ys[ty + 1], ty * columns + tx});
         }
     }
+    phases.erase(std::remove_if(phases.begin(), phases.end(),
+                                [](const std::vector<Tile>& phase) { return phase.empty(); }),
+                 phases.end());
+}
+
+void Field::reset_grid() {
+    cells.assign(static_cast<size_t>(stride) * (height + 2 * GRID_PADDING), wrap ? NO_ORGANISM : BORDER_CELL);
+    for (int y = 0; y < height; ++y) {
+        std::fill_n(cells.begin() + index_of(0, y), width, NO_ORGANISM);
+    }
+    occupancy.reset(width, height, stride, GRID_PADDING, wrap, neighbor_offsets);
+    dirty_spans.assign(static_cast<size_t>(occupancy.get_words_per_row()) * height, 1);
+}
+
+void Field::spawn_initial() {
+    // Spawn initial organisms
+    CounterRng rng(seed, tick_count, WORLD_STREAM);
+    for (int i = 0; i < rules.initial_population; ++i) {
+        int x = rng.next_int(width);
+        int y = rng.next_int(height);
+        add_organism(x, y, OrganismType::Photosynthetic);
+    }
 }
 
 void Field::tick() {
     if (!simulate) return;
+    PROFILE_SCOPE(Tick);
     ++tick_count;
+    stats.begin_tick(tick_count);
+    species.begin_tick();
 
-    // Update organisms
-    for (int x = 0; x < FIELD_WIDTH; ++x) {
-        for (int y = 0; y < FIELD_HEIGHT; ++y) {
-            if (cells[x][y]) {
-                cells[x][y]->update(this);
+    // Each organism gives birth at most once per tick, so this many free
+    // slots keep the pool from growing while workers allocate from it
+    uint32_t population = organisms.size();
+    uint32_t free_cells = static_cast<uint32_t>(width) * height - population;
+    organisms.reserve_free(std::min(population, free_cells));
+
+    if (has_vision()) {
+        PROFILE_SCOPE(Vision);
+        vision.rebuild(*this, workers.get());
+    }
+    if (has_environment()) {
+        PROFILE_SCOPE(Environment);
+        environment.update(*this, workers.get());
+    }
+    if (is_hunting()) {
+        PROFILE_SCOPE(Hunt);
+        hunt.rebuild(*this, workers.get());
+    }
+    if (has_brains()) {
+        PROFILE_SCOPE(Think);
+        think();
+    }
+    for (const auto& phase : phases) {
+        if (workers) {
+            workers->parallel_for(static_cast<int>(phase.size()), [&](int i) { update_tile(phase[i]); });
+        } else {
+            for (const Tile& tile : phase) update_tile(tile);
+        }
+        PROFILE_SCOPE(Merge);
+        for (const Tile& tile : phase) {
+            merge(tile_changes[tile.index]);
+        }
+    }
+
+    // Deaths are deferred: release slots only once nothing can touch them
+    organisms.flush();
+}
+
+void Field::update_tile(const Tile& tile) {
+    // Walk the awake organisms from the active bitboard, 64 cells at a time.
+    // The word is re-read after every update so an organism woken further
+    // along the row still acts this tick. Organisms that already acted (moved
+    // in from an earlier cell or tile, or were just born) are skipped, so
+    // everyone acts exactly once.
+    //
+    // Rows of the tile inside a chunk row with no awake organism are skipped
+    // whole. Whether to skip is decided on reaching the chunk row: until then
+    // updates above it can still wake organisms in it, and once it is empty
+    // nothing else can, as the tiles running alongside never reach this one.
+    PROFILE_SCOPE(Tile);
+    fire_timers(tile);
+    const int first_word = tile.x0 / 64;
+    const int end_word = (tile.x1 + 63) / 64;
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        if (y == tile.y0 || y % CHUNK_SIZE == 0) {
+            bool awake = false;
+            for (int k = first_word; k < end_word && !awake; ++k) {
+                awake = occupancy.is_chunk_active(k, y);
+            }
+            if (!awake) {
+                y = std::min(tile.y1, (y / CHUNK_SIZE + 1) * CHUNK_SIZE) - 1;
+                continue;
+            }
+        }
+        const uint64_t* row = occupancy.active_row_bits(y);
+        for (int k = first_word; k < end_word; ++k) {
+            uint64_t bits = row[k];
+            while (bits) {
+                int bit = count_trailing_zeros(bits);
+                OrganismId id = cells[index_of(k * 64 + bit, y)];
+                if (id < BORDER_CELL && organisms.last_tick[id] != tick_count) {
+                    Organism(*this, id, tile_changes[tile.index]).update();
+                }
+                bits = bit == 63 ? 0 : row[k] & (~uint64_t(0) << (bit + 1));
             }
         }
     }
 }
 
-void Field::draw() {
-    // Draw background
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
-    SDL_Rect rect = { FIELD_X, FIELD_Y, FIELD_WIDTH * CELL_SIZE, FIELD_HEIGHT * CELL_SIZE };
-    SDL_RenderFillRect(renderer, &rect);
+void Field::think() {
+    // Every brain senses the world as it stands at the start of the tick.
+    // Blocks are independent, so any split across workers gives the same
+    // decisions.
+    const uint32_t blocks = (organisms.capacity() + BRAIN_LANES - 1) / BRAIN_LANES;
+    const uint32_t blocks_per_job = 1024;
+    const int jobs = static_cast<int>((blocks + blocks_per_job - 1) / blocks_per_job);
+    auto job = [&](int i) {
+        uint32_t first = static_cast<uint32_t>(i) * blocks_per_job;
+        think_blocks(first, std::min(blocks, first + blocks_per_job));
+    };
+    if (workers) {
+        workers->parallel_for(jobs, job);
+    } else {
+        for (int i = 0; i < jobs; ++i) job(i);
+    }
+}
 
-    // Draw organisms
-    for (int x = 0; x < FIELD_WIDTH; ++x) {
-        for (int y = 0; y < FIELD_HEIGHT; ++y) {
-            if (cells[x][y]) {
-                cells[x][y]->draw(renderer);
+void Field::think_blocks(uint32_t first, uint32_t last) {
+    const uint32_t capacity = organisms.capacity();
+    for (uint32_t block = first; block < last; ++block) {
+        alignas(32) float energy[BRAIN_LANES] = {};
+        alignas(32) float density[BRAIN_LANES] = {};
+        const uint32_t base = block * BRAIN_LANES;
+        const uint32_t lanes = std::min<uint32_t>(BRAIN_LANES, capacity - base);
+        bool awake = false;
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            OrganismId id = base + lane;
+            if (!organisms.alive[id]) continue;
+            BrainInput input = make_brain_input(organisms.energy[id], get_density(index_of(organisms.x[id], organisms.y[id])),
+                                                sun_intensity, rules.max_energy);
+            energy[lane] = input.energy;
+            density[lane] = input.density;
+            awake |= !organisms.dormant[id];
+        }
+        // Sleepers woken later this tick think for themselves once they have
+        // caught up, so they get no decision here. That also keeps the
+        // outcome independent of how organisms are grouped into blocks.
+        uint8_t* actions = organisms.action.data() + base;
+        std::fill_n(actions, lanes, 0);
+        if (!awake) continue;
+        float outputs[BRAIN_OUTPUTS][BRAIN_LANES];
+        organisms.brains.compute_block(block, energy, density, sun_intensity, outputs);
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            OrganismId id = base + lane;
+            if (organisms.alive[id] && !organisms.dormant[id]) {
+                actions[lane] = decide_action({outputs[0][lane], outputs[1][lane], outputs[2][lane],
+                                           outputs[3][lane], outputs[4][lane], outputs[5][lane]});
             }
         }
     }
 }
 
-bool Field::add_organism(Organism* organism) {
-    int x = organism->get_x();
-    int y = organism->get_y();
-    if (!is_in_bounds(x, y) || cells[x][y]) {
-        return false;
+void Field::make_dormant(OrganismId id, uint32_t wake_tick) {
+    int x = organisms.x[id], y = organisms.y[id];
+    organisms.dormant[id] = 1;
+    organisms.wake_tick[id] = wake_tick;
+    occupancy.clear_active(x, y);
+    if (wake_tick != NO_WAKE) {
+        // Only organisms that stayed put fall asleep, so the cell lies in the
+        // tile being updated and no other worker touches this heap
+        auto& timers = wake_timers[row_tile[y] * tile_columns + column_tile[x >> 6]];
+        timers.push_back({wake_tick, id, organisms.uid[id]});
+        std::push_heap(timers.begin(), timers.end(), std::greater<WakeTimer>());
     }
-    cells[x][y] = organism;
-    return true;
 }
 
-void Field::restart() {
-    // Delete all organisms
-    for (auto& row : cells) {
-        for (auto& organism : row) {
-            delete organism;
-            organism = nullptr;
+void Field::fire_timers(const Tile& tile) {
+    auto& timers = wake_timers[tile.index];
+    // Every early wake-up leaves a stale timer behind; drop them once they
+    // outnumber the cells of the tile
+    size_t cells_in_tile = static_cast<size_t>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+    if (timers.size() > 2 * cells_in_tile) {
+        timers.erase(std::remove_if(timers.begin(), timers.end(), [&](const WakeTimer& timer) {
+            return !organisms.is_alive(timer.id) || !organisms.dormant[timer.id] ||
+                   organisms.uid[timer.id] != timer.uid || organisms.wake_tick[timer.id] != timer.tick;
+        }), timers.end());
+        std::make_heap(timers.begin(), timers.end(), std::greater<WakeTimer>());
+    }
+    while (!timers.empty() && timers.front().tick <= tick_count) {
+        WakeTimer timer = timers.front();
+        std::pop_heap(timers.begin(), timers.end(), std::greater<WakeTimer>());
+        timers.pop_back();
+        // Timers of organisms that were woken early or died are stale
+        OrganismId id = timer.id;
+        if (organisms.is_alive(id) && organisms.dormant[id] && organisms.uid[id] == timer.uid &&
+            organisms.wake_tick[id] == timer.tick) {
+            organisms.dormant[id] = 0;
+            occupancy.set_active(organisms.x[id], organisms.y[id]);
         }
     }
+}
+
+void Field::wake_neighbors(int index) {
+    for (int i = 0; i < 8; ++i) {
+        OrganismId id = cells[index + neighbor_offsets[i]];
+        if (id < BORDER_CELL && organisms.dormant[id]) {
+            organisms.dormant[id] = 0;
+            occupancy.set_active(organisms.x[id], organisms.y[id]);
+        }
+    }
+}
+
+OrganismId Field::add_organism(int x, int y, OrganismType type) {
+    if (!is_in_bounds(x, y) || cells[index_of(x, y)] != NO_ORGANISM) {
+        return NO_ORGANISM;
+    }
+    ChangeLog changes;
+    changes.recording = recording;
+    OrganismId id = Organism::spawn(*this, x, y, type, changes);
+    merge(changes);
+    return id;
+}
+
+void Field::merge(ChangeLog& changes) {
+    stats.apply(changes.stats);
+    species.apply(changes.species, tick_count);
+    if (!changes.events.empty()) {
+        events.insert(events.end(), changes.events.begin(), changes.events.end());
+        changes.events.clear();
+    }
+}
+
+void Field::set_recording(bool enabled) {
+    recording = enabled;
+    for (ChangeLog& changes : tile_changes) changes.recording = enabled;
+    events.clear();
+}
+
+void Field::kill_organism(OrganismId id, ChangeLog& changes) {
+    if (!organisms.is_alive(id)) return;
+    changes.stats.remove(organisms.type[id], organisms.energy[id], organisms.birth_tick[id], stats.get_oldest_window());
+    changes.species.push_back({organisms.species[id], organisms.founder[id], -1});
+    environment.deposit(organisms.x[id], organisms.y[id], NUTRIENT_PER_DEATH);
+    set_organism(organisms.x[id], organisms.y[id], NO_ORGANISM);
+    organisms.kill(id);
+}
+
+void Field::restart() {
+    // Drop all organisms
+    reset_grid();
+    organisms.clear();
+    for (auto& timers : wake_timers) timers.clear();
 
     // Reset tick count and simulation state
     tick_count = 0;
+    spawned = 0;
     simulate = true;
     sun_intensity = 1.0f;
+    stats.reset(tick_count);
+    species.clear();
+    environment.reset(width, height, wrap, environment.get_mode());
 
-    // Spawn new organisms
-    for (int i = 0; i < 50; ++i) {
-        int x = rand() % FIELD_WIDTH;
-        int y = rand() % FIELD_HEIGHT;
-        if (!cells[x][y]) {
-            cells[x][y] = new Organism(x, y, OrganismType::Photosynthetic);
-        }
-    }
+    spawn_initial();
+}
+
+void Field::restart(uint64_t new_seed) {
+    seed = new_seed;
+    restart();
 }
 
 bool Field::is_in_bounds(int x, int y) const {
-    return x >= 0 && x < FIELD_WIDTH && y >= 0 && y < FIELD_HEIGHT;
+    return x >= 0 && x < width && y >= 0 && y < height;
 }
 
-Organism* Field::get_organism(int x, int y) const {
-    return is_in_bounds(x, y) ? cells[x][y] : nullptr;
+OrganismId Field::get_organism(int x, int y) const {
+    if (wrap) {
+        x = ((x % width) + width) % width;
+        y = ((y % height) + height) % height;
+    }
+    return is_in_bounds(x, y) ? cells[index_of(x, y)] : NO_ORGANISM;
 }
 
-void Field::set_organism(int x, int y, Organism* organism) {
+uint32_t Field::count_kin_in_row(int y, int x0, int x1, SpeciesKey key) const {
+    const uint64_t* row = occupancy.row_bits(y);
+    uint32_t kin = 0;
+    for (int word = x0 >> 6; word <= (x1 >> 6); ++word) {
+        uint64_t bits = row[word];
+        int low = std::max(x0 - word * 64, 0);
+        int high = std::min(x1 - word * 64, 63);
+        bits &= (~uint64_t(0) << low) & (~uint64_t(0) >> (63 - high));
+        while (bits) {
+            int x = word * 64 + count_trailing_zeros(bits);
+            bits &= bits - 1;
+            if (organisms.species[cells[index_of(x, y)]] == key) ++kin;
+        }
+    }
+    return kin;
+}
+
+uint32_t Field::count_kin(OrganismId id, int radius) const {
+    const SpeciesKey key = organisms.species[id];
+    const int cx = organisms.x[id], cy = organisms.y[id];
+    radius = std::max(radius, 0);
+    // On a torus the circle must not overlap itself, or cells would count twice
+    int reach_y = wrap ? std::min(radius, (height - 1) / 2) : radius;
+    uint32_t kin = 0;
+    for (int dy = -reach_y; dy <= reach_y; ++dy) {
+        int y = cy + dy;
+        if (wrap) {
+            y = (y + height) % height;
+        } else if (y < 0 || y >= height) {
+            continue;
+        }
+        int reach_x = static_cast<int>(std::sqrt(static_cast<double>(radius * radius - dy * dy)));
+        if (wrap) reach_x = std::min(reach_x, (width - 1) / 2);
+        int x0 = cx - reach_x, x1 = cx + reach_x;
+        if (!wrap) {
+            kin += count_kin_in_row(y, std::max(x0, 0), std::min(x1, width - 1), key);
+        } else if (x0 < 0) {
+            kin += count_kin_in_row(y, x0 + width, width - 1, key) + count_kin_in_row(y, 0, x1, key);
+        } else if (x1 >= width) {
+            kin += count_kin_in_row(y, x0, width - 1, key) + count_kin_in_row(y, 0, x1 - width, key);
+        } else {
+            kin += count_kin_in_row(y, x0, x1, key);
+        }
+    }
+    return kin - 1; // The organism itself
+}
+
+void Field::set_organism(int x, int y, OrganismId id) {
     if (is_in_bounds(x, y)) {
-        cells[x][y] = organism;
+        int index = index_of(x, y);
+        bool was_free = cells[index] == NO_ORGANISM;
+        cells[index] = id;
+        mark_dirty(x, y);
+        if (wrap) sync_ghosts(x, y);
+        if (id == NO_ORGANISM) {
+            occupancy.clear_active(x, y);
+        } else if (!organisms.dormant[id]) {
+            occupancy.set_active(x, y);
+        }
+        occupancy.set_carnivorous(x, y, id != NO_ORGANISM && organisms.type[id] == OrganismType::Carnivorous);
+        if (was_free != (id == NO_ORGANISM)) {
+            if (was_free) {
+                occupancy.add(x, y, index);
+            } else {
+                occupancy.remove(x, y, index);
+            }
+            // A dormant neighbour only sleeps while nothing around it changes
+            wake_neighbors(index);
+        }
+    }
+}
+
+void Field::sync_ghosts(int x, int y) {
+    // Copy a cell near the edge into its images in the padding ring
+    int xs[2] = {x, x}, ys[2] = {y, y};
+    if (x < GRID_PADDING) xs[1] = x + width; else if (x >= width - GRID_PADDING) xs[1] = x - width;
+    if (y < GRID_PADDING) ys[1] = y + height; else if (y >= height - GRID_PADDING) ys[1] = y - height;
+    if (xs[1] == x && ys[1] == y) return;
+    OrganismId id = cells[index_of(x, y)];
+    for (int gx : xs) {
+        for (int gy : ys) {
+            cells[index_of(gx, gy)] = id;
+        }
+    }
+}
+
+void Field::update_detail(uint64_t version) {
+    detail.update(occupancy, dirty_spans.data(), version);
+    clear_dirty();
+}
+
+void Field::draw(const ViewRect& view, uint32_t* out, uint64_t since) const {
+    PROFILE_SCOPE(Draw);
+    // Views start inside the world but may run past its far edges
+    if (!since) std::fill_n(out, static_cast<size_t>(view.width) * view.height, BACKGROUND_PIXEL);
+    const int level = view.level;
+    const int columns = (width + (1 << level) - 1) >> level;  // Blocks of the world
+    const int rows = (height + (1 << level) - 1) >> level;
+    const int bx0 = view.x >> level, by0 = view.y >> level;
+    const int bx_end = std::min(columns, bx0 + view.width);
+    if (bx0 >= bx_end) return;
+    for (int j = 0; j < view.height && by0 + j < rows; ++j) {
+        const int by = by0 + j;
+        uint32_t* row = out + static_cast<size_t>(j) * view.width;
+        for (int span = bx0 >> 6; span <= (bx_end - 1) >> 6; ++span) {
+            uint64_t changed = level ? detail.get_block_version(level, by, span) : detail.get_cell_version(by, span);
+            if (since && changed <= since) continue;
+            const int first = std::max(bx0, span * 64), last = std::min(bx_end, span * 64 + 64);
+            if (level) {
+                detail.paint(level, by, first, last, row + (first - bx0));
+                continue;
+            }
+            for (int x = first; x < last; ++x) {
+                OrganismId id = cells[index_of(x, by)];
+                row[x - bx0] = id < BORDER_CELL ? to_pixel(organisms.color[id]) : BACKGROUND_PIXEL;
+            }
+        }
+    }
+}
+
+uint64_t Field::state_hash() const {
+    // Row-major over the grid so the hash ignores pool slot assignment
+    uint64_t hash = hash_combine(seed, tick_count);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            OrganismId id = cells[index_of(x, y)];
+            if (id == NO_ORGANISM) continue;
+            uint32_t energy_bits;
+            std::memcpy(&energy_bits, &organisms.energy[id], sizeof(energy_bits));
+            hash = hash_combine(hash, organisms.uid[id]);
+            hash = hash_combine(hash, (uint64_t(energy_bits) << 32) | uint32_t(get_age(id)));
+            hash = hash_combine(hash, (uint64_t(x) << 40) | (uint64_t(y) << 16) |
+                                      (uint64_t(organisms.type[id]) << 8) | organisms.direction[id]);
+        }
+    }
+    return hash;
+}
+
+static uint64_t align_checkpoint(uint64_t offset) {
+    return (offset + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+}
+
+// Fills in the section table for the header's size and population and
+// returns the size of the whole file
+static uint64_t layout_checkpoint(CheckpointHeader& header) {
+    static_assert(sizeof(Color) == 3, "Color is stored as three bytes");
+    static const uint64_t element_sizes[SECTION_COUNT] = {
+        sizeof(OrganismId), sizeof(int), sizeof(int), sizeof(float), sizeof(int), sizeof(OrganismType),
+        sizeof(uint8_t), sizeof(uint32_t), sizeof(uint8_t), sizeof(uint64_t), sizeof(uint32_t), sizeof(uint32_t),
+        sizeof(Color), sizeof(Markers), sizeof(Markers), Brain::GENOME_SIZE * sizeof(Brain::GeneType), sizeof(float)};
+    uint64_t offset = align_checkpoint(sizeof(CheckpointHeader));
+    for (int i = 0; i < SECTION_COUNT; ++i) {
+        bool per_cell = i == SECTION_CELLS || i == SECTION_NUTRIENTS;
+        uint64_t count = per_cell ? uint64_t(header.width) * header.height : header.organism_count;
+        if (i == SECTION_GENOME && !header.brains) count = 0;
+        if (i == SECTION_NUTRIENTS && header.environment != static_cast<uint8_t>(EnvironmentMode::LightAndNutrients)) count = 0;
+        header.sections[i].offset = offset;
+        header.sections[i].size = count * element_sizes[i];
+        offset = align_checkpoint(offset + header.sections[i].size);
     }
+    return offset;
+}
+
+template <typename T>
+static T* checkpoint_section(uint8_t* image, const CheckpointHeader& header, int section) {
+    return reinterpret_cast<T*>(image + header.sections[section].offset);
 }
 
-uint32_t Field::get_organism_count() const {
-    uint32_t count = 0;
-    for (const auto& row : cells) {
-        for (const auto& organism : row) {
-            if (organism) ++count;
+template <typename T>
+static const T* checkpoint_section(const uint8_t* image, const CheckpointHeader& header, int section) {
+    return reinterpret_cast<const T*>(image + header.sections[section].offset);
+}
+
+template <typename T>
+static void copy_section(std::vector<T>& into, const uint8_t* image, const CheckpointHeader& header, int section) {
+    std::memcpy(into.data(), image + header.sections[section].offset, header.sections[section].size);
+}
+
+void Field::save_checkpoint(std::vector<uint8_t>& out) const {
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.header_size = sizeof(CheckpointHeader);
+    header.width = width;
+    header.height = height;
+    header.wrap = wrap;
+    header.simulating = simulate;
+    header.brains = has_brains();
+    header.gene_bytes = sizeof(Brain::GeneType);
+    header.vision = static_cast<int8_t>(vision_level);
+    header.environment = static_cast<uint8_t>(environment.get_mode());
+    header.sun_intensity = sun_intensity;
+    header.rules = rules;
+    header.tick_count = tick_count;
+    header.organism_count = organisms.size();
+    header.seed = seed;
+    header.spawned = spawned;
+    header.total_births = stats.get_total_births();
+    header.total_deaths = stats.get_total_deaths();
+    header.total_kills = stats.get_total_kills();
+    out.assign(layout_checkpoint(header), 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    uint8_t* image = out.data();
+    OrganismId* grid = checkpoint_section<OrganismId>(image, header, SECTION_CELLS);
+    int* xs = checkpoint_section<int>(image, header, SECTION_X);
+    int* ys = checkpoint_section<int>(image, header, SECTION_Y);
+    float* energy = checkpoint_section<float>(image, header, SECTION_ENERGY);
+    int* age = checkpoint_section<int>(image, header, SECTION_AGE);
+    OrganismType* type = checkpoint_section<OrganismType>(image, header, SECTION_TYPE);
+    uint8_t* direction = checkpoint_section<uint8_t>(image, header, SECTION_DIRECTION);
+    uint32_t* last_tick = checkpoint_section<uint32_t>(image, header, SECTION_LAST_TICK);
+    uint8_t* dormant = checkpoint_section<uint8_t>(image, header, SECTION_DORMANT);
+    uint64_t* uid = checkpoint_section<uint64_t>(image, header, SECTION_UID);
+    uint32_t* birth_tick = checkpoint_section<uint32_t>(image, header, SECTION_BIRTH_TICK);
+    uint32_t* wake_tick = checkpoint_section<uint32_t>(image, header, SECTION_WAKE_TICK);
+    Color* color = checkpoint_section<Color>(image, header, SECTION_COLOR);
+    Markers* markers = checkpoint_section<Markers>(image, header, SECTION_MARKERS);
+    Markers* founders = checkpoint_section<Markers>(image, header, SECTION_FOUNDERS);
+    auto* genome = checkpoint_section<Brain::GeneType>(image, header, SECTION_GENOME);
+
+    // Gather live organisms into dense ids in grid order
+    OrganismId next = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            OrganismId id = cells[index_of(x, y)];
+            if (id >= BORDER_CELL) {
+                grid[static_cast<size_t>(y) * width + x] = NO_ORGANISM;
+                continue;
+            }
+            grid[static_cast<size_t>(y) * width + x] = next;
+            xs[next] = organisms.x[id];
+            ys[next] = organisms.y[id];
+            energy[next] = organisms.energy[id];
+            age[next] = organisms.age[id];
+            type[next] = organisms.type[id];
+            direction[next] = organisms.direction[id];
+            last_tick[next] = organisms.last_tick[id];
+            dormant[next] = organisms.dormant[id];
+            uid[next] = organisms.uid[id];
+            birth_tick[next] = organisms.birth_tick[id];
+            wake_tick[next] = organisms.wake_tick[id];
+            color[next] = organisms.color[id];
+            markers[next] = organisms.mutation_markers[id];
+            founders[next] = organisms.founder[id];
+            if (header.brains) organisms.brains.get_genome(id, genome + static_cast<size_t>(next) * Brain::GENOME_SIZE);
+            ++next;
+        }
+    }
+    if (environment.has_nutrients()) {
+        std::memcpy(checkpoint_section<float>(image, header, SECTION_NUTRIENTS), environment.get_nutrients(),
+                    header.sections[SECTION_NUTRIENTS].size);
+    }
+}
+
+bool Field::load_checkpoint(const uint8_t* data, size_t size, std::string& error) {
+    CheckpointHeader header;
+    if (size < sizeof(header)) {
+        error = "checkpoint is truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a checkpoint";
+        return false;
+    }
+    if (header.byte_order != CHECKPOINT_BYTE_ORDER) {
+        error = "checkpoint was written with a different byte order";
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION || header.header_size != sizeof(header)) {
+        error = "unsupported checkpoint version " + std::to_string(header.version);
+        return false;
+    }
+    const int max_extent = 1 << 16;
+    if (header.width < 2 * GRID_PADDING || header.height < 2 * GRID_PADDING || header.width > max_extent ||
+        header.height > max_extent || header.organism_count > uint64_t(header.width) * header.height) {
+        error = "checkpoint has an invalid world size";
+        return false;
+    }
+    if (header.environment > static_cast<uint8_t>(EnvironmentMode::LightAndNutrients)) {
+        error = "checkpoint has an unknown environment";
+        return false;
+    }
+    if (!validate_rules(header.rules, error)) {
+        error = "checkpoint has invalid rules: " + error;
+        return false;
+    }
+    if (header.brains && (header.gene_bytes != sizeof(Brain::GeneType) ||
+                          header.sections[SECTION_GENOME].size !=
+                              uint64_t(header.organism_count) * Brain::GENOME_SIZE * sizeof(Brain::GeneType))) {
+        error = "checkpoint brains have a different topology or gene type";
+        return false;
+    }
+    CheckpointHeader expected = header;
+    uint64_t expected_size = layout_checkpoint(expected);
+    if (std::memcmp(expected.sections, header.sections, sizeof(header.sections)) != 0 || expected_size > size) {
+        error = "checkpoint is truncated or corrupt";
+        return false;
+    }
+
+    // Every organism must sit in the grid cell that names it; with the
+    // number of occupied cells matching, grid and organisms agree. Types,
+    // directions and dormancy flags index tables, so they are checked too.
+    const uint32_t count = header.organism_count;
+    const int w = header.width, h = header.height;
+    const OrganismId* grid = checkpoint_section<OrganismId>(data, header, SECTION_CELLS);
+    const int* xs = checkpoint_section<int>(data, header, SECTION_X);
+    const int* ys = checkpoint_section<int>(data, header, SECTION_Y);
+    const uint8_t* types = checkpoint_section<uint8_t>(data, header, SECTION_TYPE);
+    const uint8_t* directions = checkpoint_section<uint8_t>(data, header, SECTION_DIRECTION);
+    const uint8_t* dormant = checkpoint_section<uint8_t>(data, header, SECTION_DORMANT);
+    const uint32_t* wake_tick = checkpoint_section<uint32_t>(data, header, SECTION_WAKE_TICK);
+    size_t occupied = 0;
+    for (size_t i = 0; i < static_cast<size_t>(w) * h; ++i) {
+        occupied += grid[i] != NO_ORGANISM;
+    }
+    bool consistent = occupied == count;
+    for (uint32_t i = 0; i < count && consistent; ++i) {
+        consistent = xs[i] >= 0 && xs[i] < w && ys[i] >= 0 && ys[i] < h &&
+                     grid[static_cast<size_t>(ys[i]) * w + xs[i]] == i &&
+                     types[i] <= static_cast<uint8_t>(OrganismType::Carnivorous) && directions[i] < 4 &&
+                     dormant[i] <= 1;
+    }
+    if (!consistent) {
+        error = "checkpoint grid does not match its organisms";
+        return false;
+    }
+
+    configure(w, h, header.wrap != 0);
+    seed = header.seed;
+    spawned = header.spawned;
+    tick_count = header.tick_count;
+    simulate = header.simulating != 0;
+    sun_intensity = header.sun_intensity;
+    rules = header.rules;
+    vision_level = std::max(-1, std::min<int>(header.vision, VISION_LEVELS - 1));
+    environment.reset(width, height, wrap, static_cast<EnvironmentMode>(header.environment));
+    if (environment.has_nutrients()) {
+        environment.set_nutrients(checkpoint_section<float>(data, header, SECTION_NUTRIENTS));
+    }
+
+    organisms.enable_brains(header.brains != 0);
+    organisms.assign(count);
+    copy_section(organisms.x, data, header, SECTION_X);
+    copy_section(organisms.y, data, header, SECTION_Y);
+    copy_section(organisms.energy, data, header, SECTION_ENERGY);
+    copy_section(organisms.age, data, header, SECTION_AGE);
+    copy_section(organisms.type, data, header, SECTION_TYPE);
+    copy_section(organisms.direction, data, header, SECTION_DIRECTION);
+    copy_section(organisms.last_tick, data, header, SECTION_LAST_TICK);
+    copy_section(organisms.dormant, data, header, SECTION_DORMANT);
+    copy_section(organisms.uid, data, header, SECTION_UID);
+    copy_section(organisms.birth_tick, data, header, SECTION_BIRTH_TICK);
+    copy_section(organisms.wake_tick, data, header, SECTION_WAKE_TICK);
+    copy_section(organisms.color, data, header, SECTION_COLOR);
+    copy_section(organisms.mutation_markers, data, header, SECTION_MARKERS);
+    copy_section(organisms.founder, data, header, SECTION_FOUNDERS);
+    if (header.brains) {
+        // Genomes are interleaved in memory, see NeuralNet
+        const auto* genome = checkpoint_section<Brain::GeneType>(data, header, SECTION_GENOME);
+        for (uint32_t i = 0; i < count; ++i) {
+            organisms.brains.set_genome(i, genome + static_cast<size_t>(i) * Brain::GENOME_SIZE);
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(&cells[index_of(0, y)], grid + static_cast<size_t>(y) * width, width * sizeof(OrganismId));
+    }
+    if (wrap) {
+        for (int y = 0; y < height; ++y) {
+            bool edge_row = y < GRID_PADDING || y >= height - GRID_PADDING;
+            for (int x = 0; x < width; ++x) {
+                if (!edge_row && x == GRID_PADDING) x = width - GRID_PADDING;
+                sync_ghosts(x, y);
+            }
         }
     }
-    return count;
-}
\ No newline at end of file
+
+    // Occupancy in bulk, then the wake-up timers of the sleepers
+    for (uint32_t i = 0; i < count; ++i) {
+        occupancy.place(xs[i], ys[i]);
+        if (organisms.type[i] == OrganismType::Carnivorous) occupancy.set_carnivorous(xs[i], ys[i], true);
+        if (!dormant[i]) {
+            occupancy.set_active(xs[i], ys[i]);
+        } else if (wake_tick[i] != NO_WAKE) {
+            auto& timers = wake_timers[row_tile[ys[i]] * tile_columns + column_tile[xs[i] >> 6]];
+            timers.push_back({wake_tick[i], i, organisms.uid[i]});
+        }
+    }
+    occupancy.rebuild();
+    for (auto& timers : wake_timers) {
+        std::make_heap(timers.begin(), timers.end(), std::greater<WakeTimer>());
+    }
+
+    stats.reset(tick_count);
+    for (uint32_t i = 0; i < count; ++i) {
+        stats.insert(organisms.type[i], organisms.energy[i], organisms.birth_tick[i]);
+    }
+    stats.set_totals(header.total_births, header.total_deaths, header.total_kills);
+    species.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        organisms.species[i] = species_key(organisms.founder[i]);
+        species.insert(organisms.founder[i], organisms.birth_tick[i]);
+    }
+    return true;
+}
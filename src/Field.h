@@ -1,40 +1,202 @@
 #pragma once
 
-#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
+#include "Occupancy.h"
+#include "OrganismPool.h"
+#include "Random.h"
+#include "Rules.h"
+#include "Environment.h"
+#include "Events.h"
+#include "Hunting.h"
+#include "LevelOfDetail.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
+#include "Vision.h"
 
-class Organism;
+// Default world size
+constexpr int DEFAULT_FIELD_WIDTH = 120;  // Cells
+constexpr int DEFAULT_FIELD_HEIGHT = 60;  // Cells
 
-// Constants
-constexpr int FIELD_WIDTH = 120;  // Cells
-constexpr int FIELD_HEIGHT = 60;  // Cells
-constexpr int CELL_SIZE = 10;     // Pixels
-constexpr int FIELD_X = 10;       // Screen offset
-constexpr int FIELD_Y = 10;
+// Marks the padding ring around the grid: neither free nor an organism
+constexpr OrganismId BORDER_CELL = NO_ORGANISM - 1;
+
+// Width of the padding ring. Organisms look two cells out at most (the
+// neighbours of a neighbour in Organism::find_free_direction).
+constexpr int GRID_PADDING = 2;
+
+// Tick tiles. An update reaches at most 3 cells out (move or birth one cell
+// away, plus the neighbour counts around that cell), so tiles of one phase
+// must be further apart than that. Tile columns also start on 64-cell
+// boundaries and span two bitboard words, so no two tiles running at once
+// ever touch the same Occupancy word.
+constexpr int TILE_WIDTH = 128;
+constexpr int TILE_HEIGHT = 32;
+
+struct FieldSettings {
+    int width = DEFAULT_FIELD_WIDTH;
+    int height = DEFAULT_FIELD_HEIGHT;
+    bool wrap = false;   // Toroidal world: edges are glued together
+    uint64_t seed = 1;
+    int threads = 1;     // Tick workers, including the calling thread
+    bool brains = false; // Organisms act on their NeuralNet instead of fixed rules
+    int vision = -1;     // Evo level of long-range sight, -1: neighbours only
+    EnvironmentMode environment = EnvironmentMode::Off; // Per-cell light and nutrients
+    Rules rules;
+};
+
+struct Tile {
+    int x0, y0, x1, y1; // Half-open cell rectangle
+    int index;
+};
+
+// Pending wake-up of a dormant organism, kept in a min-heap per tile
+struct WakeTimer {
+    uint32_t tick;
+    OrganismId id;
+    uint64_t uid; // Tells a recycled slot apart
+    bool operator>(const WakeTimer& other) const { return tick > other.tick; }
+};
 
 class Field {
 private:
-    std::vector<std::vector<Organism*>> cells; // 2D grid of organisms
-    SDL_Renderer* renderer;
+    // Row-major grid of organism handles with a padding ring, so organisms
+    // can probe their surroundings without bounds checks.
+    // Without wrapping the ring holds BORDER_CELL; with wrapping it mirrors
+    // the opposite edge and is kept in sync by set_organism().
+    // Allocated for the whole world, populated or not.
+    std::vector<OrganismId> cells;
+    int width, height, stride;
+    bool wrap;
+    int neighbor_offsets[8];  // Index deltas of the 8 neighbours
+    int direction_offsets[4]; // Index deltas of up, right, down, left
+    Occupancy occupancy;      // Bitboard mirror of `cells` with neighbour counts
+    // One flag per 64-cell row span whose pixels changed since the level of
+    // detail was last updated. Spans match Occupancy words, so tick workers
+    // never share one.
+    std::vector<uint8_t> dirty_spans;
+    LevelOfDetail detail;
+    OrganismPool organisms;
+    // Tiles grouped into phases; tiles of one phase never interact, so each
+    // phase runs in parallel and the outcome is independent of thread count
+    std::vector<std::vector<Tile>> phases;
+    std::vector<int> column_tile; // Tile column of every 64-cell word column
+    std::vector<int> row_tile;    // Tile row of every cell row
+    int tile_columns = 1;
+    std::vector<std::vector<WakeTimer>> wake_timers; // Per tile
+    // Population statistics and replay events. Workers record into their
+    // tile's ChangeLog, which is merged after each phase in tile order so the
+    // floating-point sums and the event order are the same for any thread count.
+    Statistics stats;
+    SpeciesIndex species;
+    VisionMap vision;      // Rebuilt at the start of every tick while in use
+    int vision_level = -1; // See FieldSettings::vision
+    Environment environment; // Updated at the start of every tick while enabled
+    HuntMap hunt;            // Likewise, while Rules::hunt_range is set
+    std::vector<ChangeLog> tile_changes;
+    std::vector<Event> events; // Merged events not yet taken by a recorder
+    bool recording = false;
+    std::unique_ptr<ThreadPool> workers;
+    Rules rules;
+    uint64_t seed;
+    uint64_t spawned = 0;   // Organisms placed by hand or at start, numbers their uids
     uint32_t tick_count = 0;
     bool simulate = true;
     float sun_intensity = 1.0f; // Added for photosynthesis
 
+    void configure(int width, int height, bool wrap);
+    void spawn_initial();
+    void reset_grid();
+    void sync_ghosts(int x, int y);
+    void build_tiles();
+    void update_tile(const Tile& tile);
+    void think();
+    void think_blocks(uint32_t first, uint32_t last);
+    void wake_neighbors(int index);
+    void merge(ChangeLog& changes);
+    uint32_t count_kin_in_row(int y, int x0, int x1, SpeciesKey key) const;
+    void fire_timers(const Tile& tile);
+
 public:
-    Field(SDL_Renderer* renderer);
-    ~Field();
+    explicit Field(const FieldSettings& settings = FieldSettings());
 
     void tick();
-    void draw();
     void restart();
+    void restart(uint64_t new_seed);
+    // Whole-world images, see Checkpoint.h for the layout and file helpers
+    void save_checkpoint(std::vector<uint8_t>& out) const;
+    bool load_checkpoint(const uint8_t* data, size_t size, std::string& error);
     bool is_simulating() const { return simulate; }
-    bool add_organism(Organism* organism);
+    bool has_brains() const { return organisms.has_brains(); }
+    const Rules& get_rules() const { return rules; }
+    bool has_vision() const { return vision_level >= 0; }
+    int get_vision_level() const { return vision_level; }
+    const VisionMap& get_vision() const { return vision; }
+    bool is_hunting() const { return rules.hunt_range > 0; }
+    const HuntMap& get_hunt() const { return hunt; }
+    bool has_environment() const { return environment.is_enabled(); }
+    Environment& get_environment() { return environment; }
+    const Environment& get_environment() const { return environment; }
+    OrganismId add_organism(int x, int y, OrganismType type);
+    void kill_organism(OrganismId id, ChangeLog& changes);
+    void make_dormant(OrganismId id, uint32_t wake_tick = NO_WAKE);
+    void mark_carnivorous(int x, int y) { occupancy.set_carnivorous(x, y, true); }
+    void mark_dirty(int x, int y) { dirty_spans[static_cast<size_t>(y) * occupancy.get_words_per_row() + (x >> 6)] = 1; }
+    const uint8_t* get_dirty_spans(int y) const { return dirty_spans.data() + static_cast<size_t>(y) * occupancy.get_words_per_row(); }
+    void clear_dirty() { std::fill(dirty_spans.begin(), dirty_spans.end(), 0); }
+    // Brings the level of detail up to date with the spans marked dirty,
+    // stamps them with `version` and clears the marks
+    void update_detail(uint64_t version);
+    // Paints `view` into `out` (ARGB, view.width x view.height) as of the
+    // last update_detail: everything if `since` is 0, otherwise only the
+    // spans stamped after `since`. Cost grows with the view, not the world.
+    void draw(const ViewRect& view, uint32_t* out, uint64_t since) const;
+    // Age including the ticks a dormant organism has slept through
+    int get_age(OrganismId id) const { return organisms.age[id] + static_cast<int>(tick_count - organisms.last_tick[id]); }
     bool is_in_bounds(int x, int y) const;
-    Organism* get_organism(int x, int y) const;
-    void set_organism(int x, int y, Organism* organism); // New method
+    OrganismId get_organism(int x, int y) const;
+    void set_organism(int x, int y, OrganismId id); // New method
+
+    // Raw grid access for hot loops, see the layout note on `cells`
+    int index_of(int x, int y) const { return (y + GRID_PADDING) * stride + (x + GRID_PADDING); }
+    OrganismId cell(int index) const { return cells[index]; }
+    // Occupied neighbours of an in-bounds cell (not a padding image)
+    int get_density(int index) const { return occupancy.get_density(index); }
+    const Occupancy& get_occupancy() const { return occupancy; }
+    const int* get_neighbor_offsets() const { return neighbor_offsets; }
+    const int* get_direction_offsets() const { return direction_offsets; }
+    // Maps a position at most one cell outside the grid back inside it.
+    // Only wrapping worlds can produce such positions from free cells.
+    void wrap_position(int& x, int& y) const {
+        if (!wrap) return;
+        if (x < 0) x += width; else if (x >= width) x -= width;
+        if (y < 0) y += height; else if (y >= height) y -= height;
+    }
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    int get_thread_count() const { return workers ? workers->size() : 1; }
+    bool is_wrapping() const { return wrap; }
+    OrganismPool& get_pool() { return organisms; }
+    const OrganismPool& get_pool() const { return organisms; }
     void toggle_simulation() { simulate = !simulate; }
     uint32_t get_tick_count() const { return tick_count; }
-    uint32_t get_organism_count() const;
+    uint64_t get_seed() const { return seed; }
+    uint64_t next_spawn_uid() { return hash_combine(seed, ++spawned); }
+    uint64_t state_hash() const;
+    uint32_t get_organism_count() const { return organisms.size(); }
+    const Statistics& get_statistics() const { return stats; }
+    const SpeciesIndex& get_species() const { return species; }
+    // Organisms of the same species within `radius` cells (Euclidean) of
+    // `id`, not counting itself. Only occupied cells are visited.
+    uint32_t count_kin(OrganismId id, int radius) const;
+    // While recording, every change to the picture is kept as an Event
+    void set_recording(bool enabled);
+    bool is_recording() const { return recording; }
+    void take_events(std::vector<Event>& out) { out.swap(events); events.clear(); }
     float get_sun_intensity() const { return sun_intensity; }
     void set_sun_intensity(float intensity) { sun_intensity = std::max(0.0f, std::min(2.0f, intensity)); }
-};
\ No newline at end of file
+};
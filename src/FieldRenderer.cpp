@@ -0,0 +1,108 @@
+#include "FieldRenderer.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <cmath>
+
+void Viewport::fit(int world_width, int world_height) {
+    zoom = std::min({static_cast<float>(CELL_SIZE), static_cast<float>(FIELD_VIEW_WIDTH) / std::max(1, world_width),
+                     static_cast<float>(FIELD_VIEW_HEIGHT) / std::max(1, world_height)});
+    zoom = std::max(zoom, MIN_ZOOM);
+    x = 0.0f;
+    y = 0.0f;
+}
+
+void Viewport::zoom_at(int screen_x, int screen_y, float factor) {
+    float new_zoom = std::min(MAX_ZOOM, std::max(MIN_ZOOM, zoom * factor));
+    float cell_x = x + (screen_x - FIELD_X) / zoom;
+    float cell_y = y + (screen_y - FIELD_Y) / zoom;
+    x = cell_x - (screen_x - FIELD_X) / new_zoom;
+    y = cell_y - (screen_y - FIELD_Y) / new_zoom;
+    zoom = new_zoom;
+}
+
+void Viewport::pan(float dx, float dy) {
+    x += dx / zoom;
+    y += dy / zoom;
+}
+
+void Viewport::clamp(int world_width, int world_height) {
+    // At least half the field area stays over the world
+    float half_width = 0.5f * FIELD_VIEW_WIDTH / zoom, half_height = 0.5f * FIELD_VIEW_HEIGHT / zoom;
+    x = std::min(std::max(x, -half_width), world_width - half_width);
+    y = std::min(std::max(y, -half_height), world_height - half_height);
+}
+
+bool Viewport::to_cell(int screen_x, int screen_y, int world_width, int world_height, int& cell_x, int& cell_y) const {
+    if (screen_x < FIELD_X || screen_y < FIELD_Y || screen_x >= FIELD_X + FIELD_VIEW_WIDTH ||
+        screen_y >= FIELD_Y + FIELD_VIEW_HEIGHT) {
+        return false;
+    }
+    cell_x = static_cast<int>(std::floor(x + (screen_x - FIELD_X) / zoom));
+    cell_y = static_cast<int>(std::floor(y + (screen_y - FIELD_Y) / zoom));
+    return cell_x >= 0 && cell_y >= 0 && cell_x < world_width && cell_y < world_height;
+}
+
+ViewRect Viewport::visible(int world_width, int world_height) const {
+    ViewRect view;
+    if (zoom < 1.0f) {
+        // Blocks at least as large as a pixel; the 1e-3 keeps an exact
+        // power of two from rounding up a level
+        view.level = std::min(DETAIL_LEVELS, static_cast<int>(std::ceil(std::log2(1.0f / zoom) - 1e-3f)));
+    }
+    const int block = 1 << view.level;
+    int x0 = std::max(0, static_cast<int>(std::floor(x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(y)));
+    int x1 = std::min(world_width, static_cast<int>(std::ceil(x + FIELD_VIEW_WIDTH / zoom)));
+    int y1 = std::min(world_height, static_cast<int>(std::ceil(y + FIELD_VIEW_HEIGHT / zoom)));
+    if (x1 <= x0 || y1 <= y0) return view;
+    view.x = x0 / block * block;
+    view.y = y0 / block * block;
+    view.width = (x1 - view.x + block - 1) / block;
+    view.height = (y1 - view.y + block - 1) / block;
+    return view;
+}
+
+FieldRenderer::FieldRenderer(SDL_Renderer* renderer) : renderer(renderer) {}
+
+FieldRenderer::~FieldRenderer() {
+    if (texture) SDL_DestroyTexture(texture);
+}
+
+void FieldRenderer::ensure_texture(int width, int height) {
+    // Images change size as the view moves; keep a texture large enough for
+    // all of them and use its top-left part
+    if (texture && texture_width >= width && texture_height >= height) return;
+    if (texture) SDL_DestroyTexture(texture);
+    texture_width = std::max(width, texture_width);
+    texture_height = std::max(height, texture_height);
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, texture_width, texture_height);
+    texture_version = 0;
+}
+
+void FieldRenderer::draw(const Snapshot& snapshot, const Viewport& viewport) {
+    const ViewRect& view = snapshot.view;
+    if (view.width <= 0 || view.height <= 0 || snapshot.image.size() != static_cast<size_t>(view.width) * view.height) return;
+    ensure_texture(view.width, view.height);
+    if (!texture) return;
+
+    if (snapshot.version != texture_version || view != texture_view) {
+        SDL_Rect area = { 0, 0, view.width, view.height };
+        SDL_UpdateTexture(texture, &area, snapshot.image.data(), view.width * static_cast<int>(sizeof(uint32_t)));
+        texture_version = snapshot.version;
+        texture_view = view;
+    }
+
+    // The image may be a frame behind the viewport; place it where its
+    // cells are now
+    const float block = viewport.zoom * (1 << view.level);
+    const float left = FIELD_X + (view.x - viewport.x) * viewport.zoom;
+    const float top = FIELD_Y + (view.y - viewport.y) * viewport.zoom;
+    SDL_Rect source = { 0, 0, view.width, view.height };
+    SDL_Rect target = { static_cast<int>(std::lround(left)), static_cast<int>(std::lround(top)),
+                        static_cast<int>(std::lround(left + view.width * block)) - static_cast<int>(std::lround(left)),
+                        static_cast<int>(std::lround(top + view.height * block)) - static_cast<int>(std::lround(top)) };
+    SDL_Rect field_area = { FIELD_X, FIELD_Y, FIELD_VIEW_WIDTH, FIELD_VIEW_HEIGHT };
+    SDL_RenderSetClipRect(renderer, &field_area);
+    SDL_RenderCopy(renderer, texture, &source, &target);
+    SDL_RenderSetClipRect(renderer, nullptr);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include "LevelOfDetail.h"
+
+struct Snapshot;
+
+// Screen layout of the field
+constexpr int CELL_SIZE = 10;     // Largest starting zoom, pixels per cell
+constexpr int FIELD_X = 10;       // Screen offset
+constexpr int FIELD_Y = 10;
+constexpr int FIELD_VIEW_WIDTH = 780;  // Pixels, left of the control panel
+constexpr int FIELD_VIEW_HEIGHT = 600; // Pixels, above the telemetry
+constexpr float MAX_ZOOM = 40.0f;
+constexpr float MIN_ZOOM = 1.0f / (1 << DETAIL_LEVELS);
+
+// Pan and zoom of the field area
+struct Viewport {
+    float x = 0.0f, y = 0.0f; // World position at the top-left corner of the field area, cells
+    float zoom = CELL_SIZE;   // Pixels per cell
+
+    // Whole world in view, at no more than CELL_SIZE
+    void fit(int world_width, int world_height);
+    // Zooms by `factor` keeping the cell under the screen position in place
+    void zoom_at(int screen_x, int screen_y, float factor);
+    void pan(float dx, float dy); // Screen pixels
+    // Keeps part of the world in view
+    void clamp(int world_width, int world_height);
+    // Cell under a screen position; false outside the field area or the world
+    bool to_cell(int screen_x, int screen_y, int world_width, int world_height, int& cell_x, int& cell_y) const;
+    // The picture to ask the simulation for: the visible cells at the finest
+    // level with no more blocks than pixels, so its size is bounded by the
+    // field area whatever the world's
+    ViewRect visible(int world_width, int world_height) const;
+};
+
+// Draws the image of a Snapshot, a picture of the part of the world in view,
+// through one streaming texture scaled to the Viewport. The image is re-sent
+// only when the snapshot changed, and is never larger than the field area.
+class FieldRenderer {
+private:
+    SDL_Renderer* renderer;
+    SDL_Texture* texture = nullptr;
+    int texture_width = 0, texture_height = 0;
+    uint64_t texture_version = 0; // Snapshot version the texture shows
+    ViewRect texture_view;
+
+    void ensure_texture(int width, int height);
+
+public:
+    FieldRenderer(SDL_Renderer* renderer);
+    ~FieldRenderer();
+
+    void draw(const Snapshot& snapshot, const Viewport& viewport);
+};
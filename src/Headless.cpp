@@ -0,0 +1,240 @@
+// Headless runner: steps the simulation as fast as possible, no SDL involved.
+#include "Checkpoint.h"
+#include "EventLog.h"
+#include "Field.h"
+#include "Profiler.h"
+#include "Simulation.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--ticks N] [--seed N] [--width N] [--height N] [--wrap] [--brains] [--vision LEVEL] [--environment light|nutrients] [--rules FILE] [--threads N] [--report-every N]"
+              << " [--load FILE] [--save FILE] [--checkpoint-every N] [--record FILE] [--trace FILE] [--share NAME]" << std::endl;
+}
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int) {
+    interrupted = 1;
+}
+
+// --share: the world runs on a Simulation thread, as under the GUI, and a
+// viewer (MyOwnWorld --attach NAME) can come and go. It runs unthrottled
+// until interrupted, or until about `ticks` if given.
+static int run_shared(const FieldSettings& settings, const std::string& name, uint64_t ticks, uint64_t report_every,
+                      const std::string& load_path, const std::string& save_path, uint64_t checkpoint_every,
+                      const std::string& record_path) {
+    Simulation simulation(settings, 0);
+    std::string error;
+    if (!load_path.empty() && !simulation.load(load_path, error)) {
+        std::cerr << "Cannot load checkpoint: " << error << std::endl;
+        return 1;
+    }
+    // Checkpoint commands from the viewer go to --save as well
+    if (!save_path.empty()) simulation.set_checkpoint(save_path, static_cast<uint32_t>(checkpoint_every));
+    if (!record_path.empty()) {
+        simulation.set_event_log(record_path);
+        simulation.post(Command{Command::Type::StartRecording});
+    }
+    if (!simulation.share(name, error)) {
+        std::cerr << "Cannot share the world: " << error << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, on_interrupt);
+    std::signal(SIGTERM, on_interrupt);
+    std::cout << "sharing as '" << name << "', attach with MyOwnWorld --attach " << name << std::endl;
+    simulation.start();
+
+    uint32_t reported = 0;
+    while (!interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const Snapshot& snapshot = simulation.latest();
+        if (report_every && snapshot.tick_count / report_every != reported / report_every) {
+            std::cout << "tick " << snapshot.tick_count << "  population " << snapshot.stats.get_population()
+                      << "  tps " << snapshot.ticks_per_second << std::endl;
+            reported = snapshot.tick_count;
+        }
+        if (ticks && snapshot.tick_count >= ticks) break;
+    }
+    simulation.post(Command{Command::Type::StopRecording});
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    simulation.stop();
+    const Snapshot& snapshot = simulation.latest();
+    std::cout << "tick: " << snapshot.tick_count << std::endl;
+    std::cout << "population: " << snapshot.stats.get_population() << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint64_t ticks = 10000;
+    FieldSettings settings;
+    uint64_t report_every = 0; // 0: only the final summary
+    std::string load_path, save_path, record_path, trace_path, share_name;
+    bool ticks_given = false;
+    uint64_t checkpoint_every = 0; // Background saves to save_path while running
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = std::strtoull(argv[++i], nullptr, 10);
+            ticks_given = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            settings.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            settings.width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            settings.height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--wrap") == 0) {
+            settings.wrap = true;
+        } else if (std::strcmp(argv[i], "--brains") == 0) {
+            settings.brains = true;
+        } else if (std::strcmp(argv[i], "--vision") == 0 && i + 1 < argc) {
+            settings.vision = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--environment") == 0 && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "light") == 0) {
+                settings.environment = EnvironmentMode::Light;
+            } else if (std::strcmp(argv[i], "nutrients") == 0) {
+                settings.environment = EnvironmentMode::LightAndNutrients;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!load_rules(argv[++i], settings.rules, error)) {
+                std::cerr << "Cannot load rules: " << error << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            settings.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--report-every") == 0 && i + 1 < argc) {
+            report_every = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            load_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            if (!PROFILER_ENABLED) {
+                std::cerr << "--trace needs a build with SIMWORLD_PROFILE=ON" << std::endl;
+                return 1;
+            }
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpoint_every = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--share") == 0 && i + 1 < argc) {
+            share_name = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    PROFILE_THREAD("main");
+    if (!share_name.empty()) {
+        if (!trace_path.empty()) {
+            std::cerr << "--trace is not available with --share" << std::endl;
+            return 1;
+        }
+        return run_shared(settings, share_name, ticks_given ? ticks : 0, report_every, load_path, save_path,
+                          checkpoint_every, record_path);
+    }
+    using Clock = std::chrono::steady_clock;
+    Field field(settings);
+    std::string error;
+    if (!load_path.empty()) {
+        auto load_start = Clock::now();
+        if (!load_checkpoint(field, load_path, error)) {
+            std::cerr << "Cannot load checkpoint: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "loaded " << load_path << " at tick " << field.get_tick_count() << " in "
+                  << std::chrono::duration<double>(Clock::now() - load_start).count() << " s" << std::endl;
+    }
+    CheckpointWriter writer;
+    std::vector<uint8_t> image;
+    EventRecorder recorder;
+    if (!record_path.empty()) {
+        if (!recorder.start(record_path, field, error)) {
+            std::cerr << "Cannot record: " << error << std::endl;
+            return 1;
+        }
+        field.set_recording(true);
+    }
+    if (!trace_path.empty()) Profiler::start_capture();
+    auto start = Clock::now();
+    auto last_report = start;
+
+    for (uint64_t t = 1; t <= ticks; ++t) {
+        field.tick();
+        if (recorder.is_recording()) recorder.append(field.get_tick_count(), field);
+        if (checkpoint_every && !save_path.empty() && t % checkpoint_every == 0) {
+            field.save_checkpoint(image);
+            writer.submit(save_path, image);
+        }
+        if (report_every && t % report_every == 0) {
+            auto now = Clock::now();
+            double elapsed = std::chrono::duration<double>(now - last_report).count();
+            std::cout << "tick " << field.get_tick_count()
+                      << "  population " << field.get_organism_count()
+                      << "  tps " << (elapsed > 0.0 ? report_every / elapsed : 0.0) << std::endl;
+            last_report = now;
+        }
+    }
+
+    recorder.stop();
+    Profiler::stop_capture();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    if (!recorder.get_last_error().empty()) {
+        std::cerr << "Cannot record: " << recorder.get_last_error() << std::endl;
+        return 1;
+    }
+    if (!save_path.empty()) {
+        field.save_checkpoint(image);
+        writer.submit(save_path, image);
+        writer.wait();
+        if (!writer.get_last_error().empty()) {
+            std::cerr << "Cannot save checkpoint: " << writer.get_last_error() << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "threads: " << field.get_thread_count() << std::endl;
+    std::cout << "ticks: " << ticks << std::endl;
+    std::cout << "seconds: " << elapsed << std::endl;
+    std::cout << "ticks/sec: " << (elapsed > 0.0 ? ticks / elapsed : 0.0) << std::endl;
+    const Statistics& stats = field.get_statistics();
+    std::cout << "population: " << field.get_organism_count()
+              << " (photosynthetic " << stats.get_count(OrganismType::Photosynthetic)
+              << ", carnivorous " << stats.get_count(OrganismType::Carnivorous) << ")" << std::endl;
+    std::cout << "mean energy: " << stats.get_mean_energy() << std::endl;
+    std::vector<SpeciesInfo> top;
+    field.get_species().get_top(1, top);
+    std::cout << "species: " << field.get_species().get_species_count()
+              << " (largest " << (top.empty() ? 0 : top[0].population) << ")" << std::endl;
+    std::cout << "births/deaths/kills: " << stats.get_total_births() << " / " << stats.get_total_deaths()
+              << " / " << stats.get_total_kills() << std::endl;
+    if (PROFILER_ENABLED) {
+        ProfileTotals totals;
+        Profiler::get_totals(totals);
+        std::cout << "profile:" << std::endl;
+        for (int i = 0; i < PROFILE_ZONE_COUNT; ++i) {
+            if (!totals.calls[i]) continue;
+            std::cout << "  " << profile_zone_name(static_cast<ProfileZone>(i)) << ": " << totals.calls[i] << " calls, "
+                      << totals.nanos[i] / 1e6 << " ms, " << totals.nanos[i] / double(totals.calls[i]) << " ns each" << std::endl;
+        }
+    }
+    if (!trace_path.empty()) {
+        if (!Profiler::write_trace(trace_path, error)) {
+            std::cerr << "Cannot write trace: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "trace: " << Profiler::get_captured_events() << " events in " << trace_path << std::endl;
+    }
+    std::cout << "state hash: " << std::hex << field.state_hash() << std::dec << std::endl;
+    return 0;
+}
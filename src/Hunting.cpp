@@ -0,0 +1,179 @@
+#include "Hunting.h"
+#include <algorithm>
+#include "Field.h"
+#include "ThreadPool.h"
+
+// Rows scanned or combined per job
+constexpr int HUNT_ROWS_PER_JOB = 64;
+
+void HuntMap::reset(int new_width, int new_height, bool new_wrap) {
+    width = new_width;
+    height = new_height;
+    wrap = new_wrap;
+    range = 0; // Everything is scanned again on the next rebuild
+}
+
+void HuntMap::rebuild(const Field& field, ThreadPool* workers) {
+    const int new_range = std::min(field.get_rules().hunt_range, MAX_HUNT_RANGE);
+    if (new_range <= 0) {
+        range = 0;
+        return;
+    }
+    const size_t cells = static_cast<size_t>(width) * height;
+    const bool all = new_range != range || distance.size() != cells;
+    if (all) {
+        range = new_range;
+        words_per_row = (width + 63) / 64;
+        prey.assign(static_cast<size_t>(words_per_row) * height, 0);
+        row_distance.assign(cells, 0);
+        distance.assign(cells, 0);
+        changed_rows.assign(height, 0);
+        stale_rows.assign(height, 0);
+    }
+
+    const Occupancy& occupancy = field.get_occupancy();
+    const int jobs = (height + HUNT_ROWS_PER_JOB - 1) / HUNT_ROWS_PER_JOB;
+    auto scan = [&](int i) {
+        scan_rows(occupancy, i * HUNT_ROWS_PER_JOB, std::min(height, (i + 1) * HUNT_ROWS_PER_JOB), all);
+    };
+    auto combine = [&](int i) {
+        combine_rows(i * HUNT_ROWS_PER_JOB, std::min(height, (i + 1) * HUNT_ROWS_PER_JOB));
+    };
+    if (workers) {
+        workers->parallel_for(jobs, scan);
+    } else {
+        for (int i = 0; i < jobs; ++i) scan(i);
+    }
+
+    // A changed row moves the distances of the rows within range of it
+    std::fill(stale_rows.begin(), stale_rows.end(), 0);
+    bool any = false;
+    for (int y = 0; y < height; ++y) {
+        if (!changed_rows[y]) continue;
+        any = true;
+        for (int dy = -range; dy <= range; ++dy) {
+            int row = y + dy;
+            if (wrap) {
+                row = ((row % height) + height) % height;
+            } else if (row < 0 || row >= height) {
+                continue;
+            }
+            stale_rows[row] = 1;
+        }
+    }
+    if (!any) return;
+    if (workers) {
+        workers->parallel_for(jobs, combine);
+    } else {
+        for (int i = 0; i < jobs; ++i) combine(i);
+    }
+}
+
+void HuntMap::scan_rows(const Occupancy& occupancy, int y0, int y1, bool all) {
+    for (int y = y0; y < y1; ++y) {
+        const uint64_t* bits = occupancy.row_bits(y);
+        const uint64_t* carnivorous = occupancy.carnivorous_row_bits(y);
+        uint64_t* row = &prey[static_cast<size_t>(y) * words_per_row];
+        bool changed = all;
+        for (int k = 0; k < words_per_row; ++k) {
+            const uint64_t word = bits[k] & ~carnivorous[k];
+            changed |= word != row[k];
+            row[k] = word;
+        }
+        changed_rows[y] = changed;
+        if (changed) scan_row(y);
+    }
+}
+
+void HuntMap::scan_row(int y) {
+    // Nearest prey to the left, then to the right, each a running count
+    // reset by every prey cell. On a torus the runs start from the far end
+    // of the row, across the seam.
+    const uint64_t* words = &prey[static_cast<size_t>(y) * words_per_row];
+    uint8_t* out = &row_distance[static_cast<size_t>(y) * width];
+    const int cap = range + 1;
+    auto is_prey = [&](int x) { return (words[x >> 6] >> (x & 63)) & 1; };
+    auto step = [&](int run, int x) { return is_prey(x) ? 0 : std::min(run + 1, cap); };
+    bool empty = true;
+    for (int k = 0; k < words_per_row && empty; ++k) empty = words[k] == 0;
+    if (empty) {
+        std::fill(out, out + width, static_cast<uint8_t>(cap));
+        return;
+    }
+    int run = cap;
+    if (wrap) {
+        for (int x = std::max(0, width - cap); x < width; ++x) run = step(run, x);
+    }
+    for (int x = 0; x < width; ++x) {
+        run = step(run, x);
+        out[x] = static_cast<uint8_t>(run);
+    }
+    run = cap;
+    if (wrap) {
+        for (int x = std::min(width, cap) - 1; x >= 0; --x) run = step(run, x);
+    }
+    for (int x = width - 1; x >= 0; --x) {
+        run = step(run, x);
+        out[x] = static_cast<uint8_t>(std::min<int>(out[x], run));
+    }
+}
+
+void HuntMap::combine_rows(int y0, int y1) {
+    // A sweep down and a sweep up each stale run of rows, carrying the
+    // nearest row distance seen so far, one further with every row. The
+    // sweeps start `range` rows out: anything further is capped anyway.
+    const uint8_t cap = static_cast<uint8_t>(range + 1);
+    std::vector<uint8_t> carried(width);
+    auto sweep = [&](int y) {
+        if (wrap) y = ((y % height) + height) % height;
+        const uint8_t* source = &row_distance[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x) {
+            const uint8_t further = static_cast<uint8_t>(carried[x] + 1);
+            carried[x] = source[x] < further ? source[x] : further;
+        }
+    };
+    for (int a = y0; a < y1;) {
+        if (!stale_rows[a]) {
+            ++a;
+            continue;
+        }
+        int b = a;
+        while (b + 1 < y1 && stale_rows[b + 1]) ++b;
+
+        std::fill(carried.begin(), carried.end(), cap);
+        for (int y = wrap ? a - range : std::max(0, a - range); y <= b; ++y) {
+            sweep(y);
+            if (y >= a) std::copy(carried.begin(), carried.end(), &distance[static_cast<size_t>(y) * width]);
+        }
+        std::fill(carried.begin(), carried.end(), cap);
+        for (int y = wrap ? b + range : std::min(height - 1, b + range); y >= a; --y) {
+            sweep(y);
+            if (y > b) continue;
+            uint8_t* out = &distance[static_cast<size_t>(y) * width];
+            for (int x = 0; x < width; ++x) out[x] = carried[x] < out[x] ? carried[x] : out[x];
+        }
+        a = b + 1;
+    }
+}
+
+int HuntMap::toward_prey(int x, int y) const {
+    static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}; // up, right, down, left
+    int best = -1;
+    int best_distance = get_distance(x, y);
+    if (best_distance > range) return -1;
+    for (int i = 0; i < 4; ++i) {
+        int nx = x + directions[i][0], ny = y + directions[i][1];
+        if (wrap) {
+            nx = (nx + width) % width;
+            ny = (ny + height) % height;
+        } else if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+            continue;
+        }
+        const int d = get_distance(nx, ny);
+        if (d < best_distance) {
+            best_distance = d;
+            best = i;
+        }
+    }
+    return best;
+}
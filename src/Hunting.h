@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Field;
+class Occupancy;
+class ThreadPool;
+
+// Largest Rules::hunt_range; distances fit a byte with room to spare
+constexpr int MAX_HUNT_RANGE = 64;
+
+// Distance from every cell to the nearest photosynthetic organism, for
+// carnivores to home in on prey with a few lookups. Distances are taxicab,
+// as the crow flies (whatever is in the way), and capped at range + 1, which
+// stands for "nothing in range".
+//
+// Built in two separable passes, each split into row bands that run in
+// parallel: the distance along each row, then the nearest of those within
+// `range` rows above or below. Only rows whose prey changed are scanned
+// again, and only the rows within `range` of those are combined again, so
+// a quiet part of the world costs a comparison of its bitboard words. Like
+// VisionMap it is rebuilt once per tick before anyone acts, so every tile
+// and thread count sees the same distances.
+class HuntMap {
+private:
+    int width = 0, height = 0;
+    bool wrap = false;
+    int range = 0;              // Rules::hunt_range it was built for, 0: not built
+    int words_per_row = 0;
+    std::vector<uint64_t> prey; // Photosynthetic bitboard the rows were scanned from
+    std::vector<uint8_t> row_distance; // To the nearest prey in the same row
+    std::vector<uint8_t> distance;
+    std::vector<uint8_t> changed_rows; // Rescanned in this rebuild
+    std::vector<uint8_t> stale_rows;   // Within `range` of a changed row
+
+    void scan_rows(const Occupancy& occupancy, int y0, int y1, bool all);
+    void scan_row(int y);
+    void combine_rows(int y0, int y1);
+
+public:
+    void reset(int width, int height, bool wrap);
+    void rebuild(const Field& field, ThreadPool* workers);
+
+    int get_range() const { return range; }
+    int get_distance(int x, int y) const { return distance[static_cast<size_t>(y) * width + x]; }
+    // Direction (0: up, 1: right, 2: down, 3: left) of the neighbour closest
+    // to prey, if it is closer than (x, y) and prey is in range; else -1
+    int toward_prey(int x, int y) const;
+};
@@ -0,0 +1,153 @@
+#include "LevelOfDetail.h"
+#include <algorithm>
+#include <cstring>
+#include "Occupancy.h"
+#include "Types.h"
+
+constexpr uint64_t EVEN_BITS = 0x5555555555555555ull;
+
+void LevelOfDetail::reset(int new_width, int new_height) {
+    width = new_width;
+    height = new_height;
+    words_per_row = (width + 63) / 64;
+    cell_versions.assign(static_cast<size_t>(words_per_row) * height, 0);
+    for (int l = 1; l <= DETAIL_LEVELS; ++l) {
+        Level& level = levels[l];
+        level.width = (width + (1 << l) - 1) >> l;
+        level.height = (height + (1 << l) - 1) >> l;
+        level.spans_per_row = (level.width + 63) / 64;
+        const size_t blocks = static_cast<size_t>(level.width) * level.height;
+        const size_t spans = static_cast<size_t>(level.spans_per_row) * level.height;
+        level.occupied.assign(blocks, 0);
+        level.carnivorous.assign(blocks, 0);
+        level.versions.assign(spans, 0);
+        level.queued.assign(spans, 0);
+        level.dirty.clear();
+    }
+}
+
+void LevelOfDetail::queue(int level, int y, int span) {
+    Level& l = levels[level];
+    const size_t index = static_cast<size_t>(y) * l.spans_per_row + span;
+    if (l.queued[index]) return;
+    l.queued[index] = 1;
+    l.dirty.push_back(static_cast<uint32_t>(index));
+}
+
+void LevelOfDetail::update(const Occupancy& occupancy, const uint8_t* dirty_spans, uint64_t version) {
+    // The cells: 64-cell span k of row y lies under level-1 span k / 2 of
+    // block row y / 2, and so on up
+    const size_t spans = cell_versions.size();
+    for (size_t i = 0; i < spans;) {
+        uint64_t chunk = 0;
+        if (i + 8 <= spans) {
+            std::memcpy(&chunk, dirty_spans + i, 8);
+            if (!chunk) {
+                i += 8;
+                continue;
+            }
+        }
+        for (size_t end = std::min(spans, i + 8); i < end; ++i) {
+            if (!dirty_spans[i]) continue;
+            cell_versions[i] = version;
+            const int y = static_cast<int>(i / words_per_row), k = static_cast<int>(i % words_per_row);
+            queue(1, y >> 1, k >> 1);
+        }
+    }
+    for (int l = 1; l <= DETAIL_LEVELS; ++l) {
+        Level& level = levels[l];
+        for (uint32_t index : level.dirty) {
+            const int by = static_cast<int>(index / level.spans_per_row), span = static_cast<int>(index % level.spans_per_row);
+            if (l == 1) {
+                count_cells(occupancy, by, span);
+            } else {
+                count_blocks(l, by, span);
+            }
+            level.versions[index] = version;
+            level.queued[index] = 0;
+            if (l < DETAIL_LEVELS) queue(l + 1, by >> 1, span >> 1);
+        }
+        level.dirty.clear();
+    }
+}
+
+void LevelOfDetail::count_cells(const Occupancy& occupancy, int by, int span) {
+    // Two cells a side: add up bit pairs of two rows, 32 blocks per word
+    Level& level = levels[1];
+    const int y0 = 2 * by, y1 = y0 + 1;
+    for (int w = 2 * span; w < std::min(words_per_row, 2 * span + 2); ++w) {
+        const int valid = std::min(64, width - 64 * w);
+        const uint64_t mask = valid == 64 ? ~uint64_t(0) : (uint64_t(1) << valid) - 1;
+        uint64_t occupied[2] = {occupancy.row_bits(y0)[w] & mask, 0};
+        uint64_t carnivorous[2] = {occupancy.carnivorous_row_bits(y0)[w] & mask, 0};
+        if (y1 < height) {
+            occupied[1] = occupancy.row_bits(y1)[w] & mask;
+            carnivorous[1] = occupancy.carnivorous_row_bits(y1)[w] & mask;
+        }
+        for (int r = 0; r < 2; ++r) {
+            occupied[r] = (occupied[r] & EVEN_BITS) + ((occupied[r] >> 1) & EVEN_BITS);
+            carnivorous[r] = (carnivorous[r] & EVEN_BITS) + ((carnivorous[r] >> 1) & EVEN_BITS);
+        }
+        const int bx0 = 32 * w;
+        const int blocks = std::min(32, level.width - bx0);
+        uint16_t* occupied_out = &level.occupied[static_cast<size_t>(by) * level.width + bx0];
+        uint16_t* carnivorous_out = &level.carnivorous[static_cast<size_t>(by) * level.width + bx0];
+        for (int i = 0; i < blocks; ++i) {
+            occupied_out[i] = static_cast<uint16_t>(((occupied[0] >> (2 * i)) & 3) + ((occupied[1] >> (2 * i)) & 3));
+            carnivorous_out[i] = static_cast<uint16_t>(((carnivorous[0] >> (2 * i)) & 3) + ((carnivorous[1] >> (2 * i)) & 3));
+        }
+    }
+}
+
+void LevelOfDetail::count_blocks(int l, int by, int span) {
+    Level& level = levels[l];
+    const Level& below = levels[l - 1];
+    const int cy = 2 * by;
+    const bool second_row = cy + 1 < below.height;
+    const uint16_t* occupied_rows[2] = {&below.occupied[static_cast<size_t>(cy) * below.width],
+                                        &below.occupied[static_cast<size_t>(cy + second_row) * below.width]};
+    const uint16_t* carnivorous_rows[2] = {&below.carnivorous[static_cast<size_t>(cy) * below.width],
+                                           &below.carnivorous[static_cast<size_t>(cy + second_row) * below.width]};
+    for (int bx = 64 * span, end = std::min(level.width, bx + 64); bx < end; ++bx) {
+        const int cx = 2 * bx;
+        const bool second_column = cx + 1 < below.width;
+        uint32_t occupied = 0, carnivorous = 0;
+        for (int r = 0; r < 1 + second_row; ++r) {
+            occupied += occupied_rows[r][cx] + (second_column ? occupied_rows[r][cx + 1] : 0);
+            carnivorous += carnivorous_rows[r][cx] + (second_column ? carnivorous_rows[r][cx + 1] : 0);
+        }
+        level.occupied[static_cast<size_t>(by) * level.width + bx] = static_cast<uint16_t>(occupied);
+        level.carnivorous[static_cast<size_t>(by) * level.width + bx] = static_cast<uint16_t>(carnivorous);
+    }
+}
+
+void LevelOfDetail::paint(int l, int by, int bx0, int bx1, uint32_t* out) const {
+    // The colour of the type most of the block's organisms have, faded
+    // towards the background by the share of cells that are empty
+    const Level& level = levels[l];
+    const int block = 1 << l;
+    const int rows = std::min(block, height - by * block);
+    for (int bx = bx0; bx < bx1; ++bx) {
+        const size_t index = static_cast<size_t>(by) * level.width + bx;
+        const int occupied = level.occupied[index];
+        if (!occupied) {
+            *out++ = BACKGROUND_PIXEL;
+            continue;
+        }
+        const int carnivorous = level.carnivorous[index];
+        const Color& color = 2 * carnivorous > occupied ? CARNIVOROUS_COLOR : PHOTOSYNTHETIC_COLOR;
+        const int area = std::min(block, width - bx * block) * rows;
+        auto fade = [&](int channel) { return static_cast<uint8_t>(255 - (255 - channel) * occupied / area); };
+        *out++ = to_pixel(Color(fade(color.r), fade(color.g), fade(color.b)));
+    }
+}
+
+void sample_view(const uint32_t* pixels, int width, int height, const ViewRect& view, uint32_t* out) {
+    for (int j = 0; j < view.height; ++j) {
+        const int y = view.y + (j << view.level);
+        for (int i = 0; i < view.width; ++i) {
+            const int x = view.x + (i << view.level);
+            *out++ = x < width && y < height ? pixels[static_cast<size_t>(y) * width + x] : BACKGROUND_PIXEL;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Occupancy;
+
+// Coarsest summary: blocks of 2^DETAIL_LEVELS cells a side
+constexpr int DETAIL_LEVELS = 7;
+
+// Part of the world to picture: an image of width x height pixels, each the
+// block of 2^level x 2^level cells starting at (x + i << level, y + j << level).
+// x and y are multiples of the block size; level 0 is one pixel per cell.
+struct ViewRect {
+    int x = 0, y = 0;
+    int width = 0, height = 0;
+    int level = 0;
+
+    bool operator==(const ViewRect& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height && level == other.level;
+    }
+    bool operator!=(const ViewRect& other) const { return !(*this == other); }
+};
+
+// Organism counts per block at every level, for pictures of more cells than
+// there are pixels. Only blocks over cells that changed are recounted: level
+// 1 from the occupancy bitboards, each further level from the four blocks
+// below it. Every 64-block span of every level, and every 64-cell span of
+// the cells, is stamped with the version it last changed in, so a picture
+// can be brought up to date by repainting only what changed since.
+class LevelOfDetail {
+private:
+    struct Level {
+        int width = 0, height = 0; // Blocks
+        int spans_per_row = 0;     // 64-block spans
+        std::vector<uint16_t> occupied;
+        std::vector<uint16_t> carnivorous;
+        std::vector<uint64_t> versions;   // Per span
+        std::vector<uint8_t> queued;      // Per span, set while in `dirty`
+        std::vector<uint32_t> dirty;      // Spans to recount
+    };
+
+    int width = 0, height = 0;
+    int words_per_row = 0;
+    std::vector<uint64_t> cell_versions; // Per 64-cell span of the cells
+    Level levels[DETAIL_LEVELS + 1];     // levels[0] is unused: cells have no counts
+
+    void queue(int level, int y, int span);
+    void count_cells(const Occupancy& occupancy, int by, int span);
+    void count_blocks(int level, int by, int span);
+
+public:
+    void reset(int width, int height);
+    // Recounts the blocks over the 64-cell spans flagged in `dirty_spans`
+    // (one byte per span, rows one after another) and stamps them
+    void update(const Occupancy& occupancy, const uint8_t* dirty_spans, uint64_t version);
+
+    uint64_t get_cell_version(int y, int span) const { return cell_versions[static_cast<size_t>(y) * words_per_row + span]; }
+    uint64_t get_block_version(int level, int by, int span) const {
+        const Level& l = levels[level];
+        return l.versions[static_cast<size_t>(by) * l.spans_per_row + span];
+    }
+    // Paints the blocks of row `by` with bx in [bx0, bx1) at `level` >= 1
+    void paint(int level, int by, int bx0, int bx1, uint32_t* out) const;
+};
+
+// Paints `view` from a full picture of the world (width x height, a pixel
+// per cell), taking the top-left cell of each block. For worlds known only
+// as pixels, such as replays.
+void sample_view(const uint32_t* pixels, int width, int height, const ViewRect& view, uint32_t* out);
@@ -1,16 +1,62 @@
 #include "Main.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <thread>
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_sdlrenderer2.h"
 
-Main::Main() : window(nullptr), renderer(nullptr), field(nullptr), running(true), limit_tps(60), tick_interval(1000 / 60), last_tick(0) {
+// Checkpoint in the working directory, also written in the background
+static const char* CHECKPOINT_FILE = "world.ckpt";
+static const char* EVENT_LOG_FILE = "world.evlog";
+static const char* TRACE_FILE = "world.trace.json";
+static const char* RULES_FILE = "world.rules"; // Optional, see Rules.h
+constexpr Uint32 PROFILE_SAMPLE_MS = 500;
+constexpr uint32_t AUTOSAVE_TICKS = 100000;
+
+Main::Main(const std::string& attach_name) : window(nullptr), renderer(nullptr), simulation(nullptr), viewer(nullptr), attached_name(attach_name), snapshot(nullptr), field_renderer(nullptr), panning(false), running(true), limit_tps(60), unlimited_tps(false), history_choice(1),
+               show_profiler(false), profile_sampled(0),
+               replay(nullptr), replay_renderer(nullptr), replay_frame_tick(0), replay_tick(0), replay_speed(10), replay_playing(false) {
     init_sdl();
     init_imgui();
-    field = new Field(renderer);
+    field_renderer = new FieldRenderer(renderer);
+    if (!attach_name.empty()) {
+        viewer = new SharedWorldViewer();
+        std::string error;
+        if (!viewer->attach(attach_name, error)) {
+            std::cerr << "Cannot attach: " << error << std::endl;
+            exit(1);
+        }
+        snapshot = &viewer->latest();
+        unlimited_tps = true; // The headless run is unthrottled
+        viewport.fit(snapshot->width, snapshot->height);
+        return;
+    }
+    FieldSettings settings;
+    settings.seed = std::random_device{}();
+    // One core drives the UI, the rest tick the world
+    settings.threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    settings.brains = true;
+    std::string error;
+    if (std::ifstream(RULES_FILE) && !load_rules(RULES_FILE, settings.rules, error)) {
+        std::cerr << "Ignoring rules: " << error << std::endl;
+    }
+    simulation = new Simulation(settings, limit_tps);
+    simulation->set_checkpoint(CHECKPOINT_FILE, AUTOSAVE_TICKS);
+    simulation->set_event_log(EVENT_LOG_FILE);
+    snapshot = &simulation->latest();
+    viewport.fit(settings.width, settings.height);
+    simulation->start();
 }
 
 Main::~Main() {
-    delete field;
+    close_replay();
+    delete field_renderer;
+    delete simulation;
+    delete viewer;
     ImPlot::DestroyContext();
     ImGui::DestroyContext();
     SDL_DestroyRenderer(renderer);
@@ -30,7 +76,7 @@ void Main::init_sdl() {
         exit(1);
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) {
         std::cerr << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
         exit(1);
@@ -47,6 +93,7 @@ void Main::init_imgui() {
 }
 
 void Main::draw_gui() {
+    PROFILE_SCOPE(DrawGui);
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
@@ -54,33 +101,303 @@ void Main::draw_gui() {
     ImGui::SetNextWindowPos(ImVec2(800, 10));
     ImGui::SetNextWindowSize(ImVec2(190, 580));
     ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
-    if (ImGui::Button(field->is_simulating() ? "Pause" : "Resume")) {
-        field->toggle_simulation();
+    if (ImGui::Button(snapshot->simulating ? "Pause" : "Resume")) {
+        toggle_simulation();
     }
     ImGui::SameLine(); // Place Restart button next to Pause/Resume
     if (ImGui::Button("Restart")) {
-        field->restart();
+        restart();
+    }
+    if (ImGui::Button("Save")) {
+        post(Command{Command::Type::SaveCheckpoint});
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        post(Command{Command::Type::LoadCheckpoint});
+    }
+    if (ImGui::Button(snapshot->recording ? "Stop recording" : "Record")) {
+        post(Command{snapshot->recording ? Command::Type::StopRecording : Command::Type::StartRecording});
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Replay")) {
+        open_replay();
+    }
+    ImGui::Checkbox("Profiler", &show_profiler);
+    if (viewer) {
+        ImGui::TextWrapped(viewer->is_connected() ? "Attached to '%s'" : "'%s' has exited", attached_name.c_str());
+    }
+    if (!replay_status.empty()) {
+        ImGui::TextWrapped("%s", replay_status.c_str());
+    }
+    if (!snapshot->checkpoint_status.empty()) {
+        ImGui::TextWrapped("%s", snapshot->checkpoint_status.c_str());
     }
-    ImGui::SliderInt("TPS", &limit_tps, 1, 150);
-    tick_interval = 1000 / limit_tps;
-    ImGui::Text("Organisms: %u", field->get_organism_count());
-    ImGui::Text("Ticks: %u", field->get_tick_count());
+    bool tps_changed = ImGui::Checkbox("Unlimited TPS", &unlimited_tps);
+    if (!unlimited_tps) {
+        tps_changed |= ImGui::SliderInt("TPS", &limit_tps, 1, 1000);
+    }
+    if (tps_changed) {
+        Command command{Command::Type::SetTps};
+        command.tps = unlimited_tps ? 0 : limit_tps;
+        post(command);
+    }
+    const Statistics& stats = snapshot->stats;
+    ImGui::Text("Organisms: %u", stats.get_population());
+    ImGui::Text("Ticks: %u", snapshot->tick_count);
+    ImGui::Text("Actual TPS: %.0f", snapshot->ticks_per_second);
+    ImGui::Text("Seed: %llu", static_cast<unsigned long long>(snapshot->seed));
     
     // Statistics window
-    ImGui::BeginChild("Statistics", ImVec2(0, 100), true);
+    ImGui::BeginChild("Statistics", ImVec2(0, 330), true);
     ImGui::Text("Statistics");
     ImGui::Separator();
-    ImGui::Text("Total Organisms: %u", field->get_organism_count());
+    ImGui::Text("Photosynthetic: %u", stats.get_count(OrganismType::Photosynthetic));
+    ImGui::Text("Carnivorous: %u", stats.get_count(OrganismType::Carnivorous));
+    ImGui::Text("Energy: %.0f", stats.get_total_energy());
+    ImGui::Text("Mean energy: %.1f", stats.get_mean_energy());
+    ImGui::Text("Births/tick: %u", stats.get_births());
+    ImGui::Text("Deaths/tick: %u", stats.get_deaths());
+    ImGui::Text("Kills/tick: %u", stats.get_kills());
+    ImGui::Text("Total births: %llu", static_cast<unsigned long long>(stats.get_total_births()));
+    ImGui::Text("Total kills: %llu", static_cast<unsigned long long>(stats.get_total_kills()));
+    // Age distribution, AGE_BUCKET_TICKS per bar, the last bar everything older
+    uint32_t ages[AGE_BUCKETS + 1];
+    float bars[AGE_BUCKETS + 1];
+    stats.get_age_histogram(ages);
+    for (int i = 0; i <= AGE_BUCKETS; ++i) bars[i] = static_cast<float>(ages[i]);
+    ImGui::Text("Age distribution");
+    ImGui::PlotHistogram("##ages", bars, AGE_BUCKETS + 1, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+    ImGui::EndChild();
+
+    // Species window: the most populous ones, with the tick they appeared
+    ImGui::BeginChild("Species", ImVec2(0, 0), true);
+    ImGui::Text("Species: %u (+%u -%u)", snapshot->species_count, snapshot->species_appeared, snapshot->species_extinct);
+    ImGui::Separator();
+    for (const SpeciesInfo& info : snapshot->top_species) {
+        ImGui::Text("%u since %u", info.population, info.origin_tick);
+    }
     ImGui::EndChild();
 
     ImGui::End();
 
+    if (replay) {
+        draw_replay();
+    } else {
+        draw_telemetry();
+    }
+    if (show_profiler) {
+        draw_profiler();
+    }
+
     ImGui::Render();
     ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData());
 }
 
+void Main::draw_telemetry() {
+    static const char* spans[] = {"1K ticks", "10K ticks", "100K ticks", "1M ticks", "Whole run"};
+    static const uint32_t span_ticks[] = {1000, 10000, 100000, 1000000, 0};
+
+    ImGui::SetNextWindowPos(ImVec2(10, 620));
+    ImGui::SetNextWindowSize(ImVec2(980, 170));
+    ImGui::Begin("Telemetry", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::Combo("History", &history_choice, spans, IM_ARRAYSIZE(spans))) {
+        Command command{Command::Type::SetHistory};
+        command.history_ticks = span_ticks[history_choice];
+        post(command);
+    }
+
+    const ImVec2 size(236, 110);
+    if (ImPlot::BeginPlot("Population", size, ImPlotFlags_NoMouseText)) {
+        ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        plot_metric("Photosynthetic", Metric::Photosynthetic);
+        plot_metric("Carnivorous", Metric::Carnivorous);
+        ImPlot::EndPlot();
+    }
+    ImGui::SameLine();
+    if (ImPlot::BeginPlot("Mean energy", size, ImPlotFlags_NoMouseText | ImPlotFlags_NoLegend)) {
+        ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        plot_metric("Energy", Metric::MeanEnergy);
+        ImPlot::EndPlot();
+    }
+    ImGui::SameLine();
+    if (ImPlot::BeginPlot("Births / deaths", size, ImPlotFlags_NoMouseText)) {
+        ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        plot_metric("Births", Metric::Births);
+        plot_metric("Deaths", Metric::Deaths);
+        ImPlot::EndPlot();
+    }
+    ImGui::SameLine();
+    if (ImPlot::BeginPlot("Tick time, us", size, ImPlotFlags_NoMouseText | ImPlotFlags_NoLegend)) {
+        ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        plot_metric("Tick", Metric::TickMicros);
+        ImPlot::EndPlot();
+    }
+    ImGui::End();
+}
+
+void Main::plot_metric(const char* label, Metric metric) {
+    // Mean as a line over the min/max band of every decimated point
+    const std::vector<TelemetryPoint>& history = snapshot->history;
+    const int m = static_cast<int>(metric);
+    plot_x.resize(history.size());
+    plot_min.resize(history.size());
+    plot_max.resize(history.size());
+    plot_mean.resize(history.size());
+    for (size_t i = 0; i < history.size(); ++i) {
+        plot_x[i] = static_cast<float>(history[i].tick);
+        plot_min[i] = history[i].min[m];
+        plot_max[i] = history[i].max[m];
+        plot_mean[i] = history[i].mean[m];
+    }
+    const int count = static_cast<int>(history.size());
+    ImPlot::PlotShaded(label, plot_x.data(), plot_min.data(), plot_max.data(), count);
+    ImPlot::PlotLine(label, plot_x.data(), plot_mean.data(), count);
+}
 
+void Main::draw_profiler() {
+    ImGui::SetNextWindowPos(ImVec2(560, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(230, 330), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler", &show_profiler);
+    if (!PROFILER_ENABLED) {
+        ImGui::TextWrapped("Built without the profiler; configure with -DSIMWORLD_PROFILE=ON.");
+        ImGui::End();
+        return;
+    }
+    if (ImGui::Button(Profiler::is_capturing() ? "Stop trace" : "Trace")) {
+        if (Profiler::is_capturing()) {
+            Profiler::stop_capture();
+        } else {
+            Profiler::start_capture();
+            profile_status.clear();
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace")) {
+        std::string error;
+        profile_status = Profiler::write_trace(TRACE_FILE, error) ? std::string("Saved ") + TRACE_FILE : error;
+    }
+    ImGui::Text("Traced events: %llu", static_cast<unsigned long long>(Profiler::get_captured_events()));
+    if (!profile_status.empty()) {
+        ImGui::TextWrapped("%s", profile_status.c_str());
+    }
 
+    // Rates over the last sample, so the table stays readable
+    Uint32 now = SDL_GetTicks();
+    if (now - profile_sampled >= PROFILE_SAMPLE_MS) {
+        ProfileTotals totals;
+        Profiler::get_totals(totals);
+        float seconds = profile_sampled ? (now - profile_sampled) / 1000.0f : 0.0f;
+        for (int i = 0; i < PROFILE_ZONE_COUNT; ++i) {
+            uint64_t calls = totals.calls[i] - profile_totals.calls[i];
+            uint64_t nanos = totals.nanos[i] - profile_totals.nanos[i];
+            profile_ms[i] = seconds > 0.0f ? nanos / 1e6f / seconds : 0.0f;
+            profile_ns[i] = calls ? static_cast<float>(nanos) / calls : 0.0f;
+        }
+        profile_totals = totals;
+        profile_sampled = now;
+    }
+    if (ImGui::BeginTable("Zones", 3, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("ms/s");
+        ImGui::TableSetupColumn("ns/call");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < PROFILE_ZONE_COUNT; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(profile_zone_name(static_cast<ProfileZone>(i)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", profile_ms[i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", profile_ns[i]);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void Main::open_replay() {
+    close_replay();
+    replay = new EventLogReader();
+    std::string error;
+    if (!replay->open(EVENT_LOG_FILE, error)) {
+        replay_status = "Replay failed: " + error;
+        close_replay();
+        return;
+    }
+    replay_status.clear();
+    replay_renderer = new FieldRenderer(renderer);
+    replay_tick = static_cast<int>(replay->get_first_tick());
+    replay_playing = false;
+    replay_snapshot = Snapshot();
+    replay_snapshot.seed = replay->get_seed();
+    replay_snapshot.simulating = false;
+    update_replay();
+}
+
+void Main::close_replay() {
+    delete replay;
+    delete replay_renderer;
+    replay = nullptr;
+    replay_renderer = nullptr;
+}
+
+void Main::update_replay() {
+    if (replay_playing) {
+        replay_tick = static_cast<int>(std::min<int64_t>(int64_t(replay_tick) + replay_speed, replay->get_last_tick()));
+        replay_playing = replay_tick < static_cast<int>(replay->get_last_tick());
+    }
+    const ReplayFrame& frame = replay->get_frame();
+    if (frame.tick != static_cast<uint32_t>(replay_tick) || frame.pixels.empty() || !replay_snapshot.version) {
+        if (!replay->seek(static_cast<uint32_t>(replay_tick))) {
+            replay_status = "Replay failed: the event log is corrupt";
+            replay_playing = false;
+        }
+        replay_tick = static_cast<int>(frame.tick); // Short of the target only at a damaged end of log
+    }
+    // Frames are whole pictures of the world; sample the part in view
+    viewport.clamp(frame.width, frame.height);
+    ViewRect view = viewport.visible(frame.width, frame.height);
+    if (replay_snapshot.version && frame.tick == replay_frame_tick && view == replay_snapshot.view) return;
+    ++replay_snapshot.version;
+    replay_snapshot.width = frame.width;
+    replay_snapshot.height = frame.height;
+    replay_snapshot.tick_count = frame.tick;
+    replay_snapshot.view = view;
+    replay_snapshot.image.resize(static_cast<size_t>(view.width) * view.height);
+    sample_view(frame.pixels.data(), frame.width, frame.height, view, replay_snapshot.image.data());
+    replay_frame_tick = frame.tick;
+}
+
+void Main::draw_replay() {
+    ImGui::SetNextWindowPos(ImVec2(10, 620));
+    ImGui::SetNextWindowSize(ImVec2(980, 170));
+    ImGui::Begin("Replay", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
+    if (ImGui::Button(replay_playing ? "Pause" : "Play")) {
+        replay_playing = !replay_playing;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Back to live")) {
+        close_replay();
+        ImGui::End();
+        return;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reload")) {
+        // Picks up what the recorder has written since
+        int tick = replay_tick;
+        open_replay();
+        if (!replay) {
+            ImGui::End();
+            return;
+        }
+        replay_tick = std::min(tick, static_cast<int>(replay->get_last_tick()));
+    }
+    ImGui::SliderInt("Tick", &replay_tick, static_cast<int>(replay->get_first_tick()), static_cast<int>(replay->get_last_tick()));
+    ImGui::SliderInt("Ticks per frame", &replay_speed, 1, 200);
+    ImGui::Text("Showing tick %u of %u-%u", replay->get_frame().tick, replay->get_first_tick(), replay->get_last_tick());
+    ImGui::End();
+}
 
 void Main::handle_input() {
     SDL_Event event;
@@ -93,14 +410,45 @@ void Main::handle_input() {
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                     case SDLK_SPACE:
-                        field->toggle_simulation();
+                        toggle_simulation();
                         break;
                     case SDLK_r:
-                        field->restart();
+                        restart();
+                        break;
+                    case SDLK_F5:
+                        post(Command{Command::Type::SaveCheckpoint});
+                        break;
+                    case SDLK_F9:
+                        post(Command{Command::Type::LoadCheckpoint});
+                        break;
+                    case SDLK_HOME:
+                        viewport.fit(snapshot->width, snapshot->height);
+                        break;
+                    case SDLK_EQUALS:
+                    case SDLK_PLUS:
+                        viewport.zoom_at(FIELD_X + FIELD_VIEW_WIDTH / 2, FIELD_Y + FIELD_VIEW_HEIGHT / 2, 2.0f);
+                        break;
+                    case SDLK_MINUS:
+                        viewport.zoom_at(FIELD_X + FIELD_VIEW_WIDTH / 2, FIELD_Y + FIELD_VIEW_HEIGHT / 2, 0.5f);
+                        break;
+                    case SDLK_LEFT:
+                        viewport.pan(-FIELD_VIEW_WIDTH / 8.0f, 0.0f);
+                        break;
+                    case SDLK_RIGHT:
+                        viewport.pan(FIELD_VIEW_WIDTH / 8.0f, 0.0f);
+                        break;
+                    case SDLK_UP:
+                        viewport.pan(0.0f, -FIELD_VIEW_HEIGHT / 8.0f);
+                        break;
+                    case SDLK_DOWN:
+                        viewport.pan(0.0f, FIELD_VIEW_HEIGHT / 8.0f);
                         break;
                 }
                 break;
             case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+            case SDL_MOUSEMOTION:
+            case SDL_MOUSEWHEEL:
                 handle_mouse_input(event); // Добавлено
                 break;
         }
@@ -108,10 +456,29 @@ void Main::handle_input() {
 }
 
 void Main::handle_mouse_input(const SDL_Event& event) {
+    // Dragging with the middle button pans, the wheel zooms about the cursor
+    if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_MIDDLE) {
+        panning = false;
+    }
+    if (event.type == SDL_MOUSEMOTION && panning) {
+        viewport.pan(static_cast<float>(-event.motion.xrel), static_cast<float>(-event.motion.yrel));
+    }
+
     // Игнорировать клики, если ImGui перехватывает мышь
     if (ImGui::GetIO().WantCaptureMouse) {
         return;
     }
+    if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+        int mouse_x, mouse_y;
+        SDL_GetMouseState(&mouse_x, &mouse_y);
+        viewport.zoom_at(mouse_x, mouse_y, std::pow(1.25f, static_cast<float>(event.wheel.y)));
+    }
+    if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_MIDDLE) {
+        panning = true;
+    }
+    if (replay) {
+        return;
+    }
 
     if (event.type == SDL_MOUSEBUTTONDOWN) {
         if (event.button.button == SDL_BUTTON_LEFT) {
@@ -124,29 +491,62 @@ void Main::handle_mouse_input(const SDL_Event& event) {
 
 void Main::create_organism(int mouse_x, int mouse_y, OrganismType type) {
     // Преобразовать экранные координаты в координаты поля
-    int field_x = (mouse_x - FIELD_X) / CELL_SIZE;
-    int field_y = (mouse_y - FIELD_Y) / CELL_SIZE;
+    int field_x, field_y;
 
-    // Проверить, что координаты внутри поля и клетка свободна
-    if (field->is_in_bounds(field_x, field_y) && !field->get_organism(field_x, field_y)) {
-        Organism* organism = new Organism(field_x, field_y, type);
-        field->add_organism(organism);
+    // Проверить, что координаты внутри поля; свободна ли клетка, проверит симуляция
+    if (viewport.to_cell(mouse_x, mouse_y, snapshot->width, snapshot->height, field_x, field_y)) {
+        Command command{Command::Type::Spawn};
+        command.x = field_x;
+        command.y = field_y;
+        command.organism_type = type;
+        post(command);
     }
 }
 
+void Main::update_view() {
+    // Ask for the picture of what is in view whenever that changes
+    viewport.clamp(snapshot->width, snapshot->height);
+    ViewRect view = viewport.visible(snapshot->width, snapshot->height);
+    if (view == requested_view) return;
+    Command command{Command::Type::SetView};
+    command.view = view;
+    if (post(command)) requested_view = view; // Otherwise again next frame
+}
+
+bool Main::post(const Command& command) {
+    return viewer ? viewer->post(command) : simulation->post(command);
+}
+
+void Main::toggle_simulation() {
+    post(Command{Command::Type::TogglePause});
+}
+
+void Main::restart() {
+    Command command{Command::Type::Restart};
+    command.seed = std::random_device{}();
+    post(command);
+}
+
 
 
 void Main::run() {
+    PROFILE_THREAD("gui");
     while (running) {
+        // The world ticks on its own thread; a frame only shows its latest state
+        snapshot = viewer ? &viewer->latest() : &simulation->latest();
         handle_input();
-        uint32_t current_time = SDL_GetTicks();
-        if (current_time - last_tick >= tick_interval) {
-            field->tick();
-            last_tick = current_time;
+        if (replay) {
+            update_replay();
+        } else {
+            update_view();
         }
         SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
         SDL_RenderClear(renderer);
-        field->draw();
+        if (replay) {
+            replay_renderer->draw(replay_snapshot, viewport);
+        } else {
+            field_renderer->draw(*snapshot, viewport);
+        }
         draw_gui();
         SDL_RenderPresent(renderer);
     }
@@ -154,8 +554,17 @@ void Main::run() {
 
 
 
-int main() {
-    Main app;
+int main(int argc, char** argv) {
+    std::string attach_name;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--attach") == 0 && i + 1 < argc) {
+            attach_name = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--attach NAME]" << std::endl;
+            return 1;
+        }
+    }
+    Main app(attach_name);
     app.run();
     return 0;
 }
\ No newline at end of file
@@ -3,29 +3,70 @@
 #include <SDL2/SDL.h>
 #include "imgui.h"
 #include "implot.h"
-#include "Field.h"
-#include "Organism.h"
+#include "EventLog.h"
+#include "FieldRenderer.h"
+#include "Profiler.h"
+#include "SharedWorld.h"
+#include "Simulation.h"
 
 class Main {
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
-    Field* field;
+    Simulation* simulation;   // Runs the world in this process, or
+    SharedWorldViewer* viewer; // is attached to one run by simworld_headless --share
+    std::string attached_name;
+    const Snapshot* snapshot; // Latest picture of the world, refreshed every frame
+    FieldRenderer* field_renderer;
+    Viewport viewport;
+    ViewRect requested_view; // Last view sent to the simulation
+    bool panning;            // Middle button held over the field
     bool running;
     int limit_tps;
-    int tick_interval;
-    uint32_t last_tick;
+    bool unlimited_tps;
+    int history_choice; // Index into the history spans of the Telemetry window
+    std::vector<float> plot_x, plot_min, plot_max, plot_mean; // Chart buffers
+
+    // Profiler window: zone times per second over the last sample period
+    bool show_profiler;
+    ProfileTotals profile_totals; // At the last sample
+    Uint32 profile_sampled;       // SDL_GetTicks of the last sample
+    float profile_ms[PROFILE_ZONE_COUNT] = {};    // Milliseconds per second
+    float profile_ns[PROFILE_ZONE_COUNT] = {};    // Nanoseconds per call
+    std::string profile_status;
+
+    // Replay of a recorded run, shown instead of the live world while open
+    EventLogReader* replay;
+    FieldRenderer* replay_renderer;
+    Snapshot replay_snapshot;
+    uint32_t replay_frame_tick; // Frame and view replay_snapshot was painted from
+    int replay_tick;
+    int replay_speed; // Ticks per frame while playing
+    bool replay_playing;
+    std::string replay_status;
 
     void init_sdl();
     void init_imgui();
     void draw_gui();
+    void draw_telemetry();
+    void plot_metric(const char* label, Metric metric);
+    void draw_profiler();
+    void open_replay();
+    void close_replay();
+    void update_replay();
+    void draw_replay();
     void handle_input();
 
     void handle_mouse_input(const SDL_Event& event); 
+    bool post(const Command& command);
+    void update_view();
     void create_organism(int mouse_x, int mouse_y, OrganismType type); 
+    void toggle_simulation();
+    void restart();
 
 public:
-    Main();
+    // Attaches to the shared world `attach_name` if given, else runs its own
+    explicit Main(const std::string& attach_name = "");
     ~Main();
     void run();
 };
\ No newline at end of file
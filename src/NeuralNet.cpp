@@ -1,54 +1,339 @@
 #include "NeuralNet.h"
-#include <cmath>
-#include <random>
-
-NeuralNet::NeuralNet() : rng(std::random_device{}()) {
-    weights1.resize(INPUT_SIZE, std::vector<float>(HIDDEN_SIZE));
-    weights2.resize(HIDDEN_SIZE, std::vector<float>(OUTPUT_SIZE));
-    biases1.resize(HIDDEN_SIZE);
-    biases2.resize(OUTPUT_SIZE);
-
-    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
-    for (auto& row : weights1) for (auto& w : row) w = dist(rng);
-    for (auto& row : weights2) for (auto& w : row) w = dist(rng);
-    for (auto& b : biases1) b = dist(rng);
-    for (auto& b : biases2) b = dist(rng);
-}
-
-BrainOutput NeuralNet::compute(const BrainInput& input) const {
-    std::vector<float> inputs = {input.energy, input.density, input.sun_intensity};
-    std::vector<float> hidden(HIDDEN_SIZE, 0.0f);
-
-    // Input -> Hidden
-    for (int i = 0; i < INPUT_SIZE; ++i) {
-        for (int j = 0; j < HIDDEN_SIZE; ++j) {
-            hidden[j] += inputs[i] * weights1[i][j];
-        }
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define SIMWORLD_SSE2 1
+#endif
+
+namespace {
+
+// The few lane operations the float kernel needs, for the widest vector the
+// build targets. Only IEEE-exact operations are used (no FMA, no approximate
+// reciprocal), which keeps every width bit-identical.
+#if defined(__AVX__)
+using Lanes = __m256;
+constexpr int LANE_WIDTH = 8;
+inline Lanes load(const float* p) { return _mm256_load_ps(p); }
+inline Lanes load_unaligned(const float* p) { return _mm256_loadu_ps(p); }
+inline Lanes broadcast(float v) { return _mm256_set1_ps(v); }
+inline void store(float* p, Lanes v) { _mm256_storeu_ps(p, v); }
+inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes div(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+inline Lanes clamp(Lanes v, Lanes lo, Lanes hi) { return _mm256_min_ps(_mm256_max_ps(v, lo), hi); }
+#elif defined(SIMWORLD_SSE2)
+using Lanes = __m128;
+constexpr int LANE_WIDTH = 4;
+inline Lanes load(const float* p) { return _mm_load_ps(p); }
+inline Lanes load_unaligned(const float* p) { return _mm_loadu_ps(p); }
+inline Lanes broadcast(float v) { return _mm_set1_ps(v); }
+inline void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes div(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+inline Lanes clamp(Lanes v, Lanes lo, Lanes hi) { return _mm_min_ps(_mm_max_ps(v, lo), hi); }
+#else
+using Lanes = float;
+constexpr int LANE_WIDTH = 1;
+inline Lanes load(const float* p) { return *p; }
+inline Lanes load_unaligned(const float* p) { return *p; }
+inline Lanes broadcast(float v) { return v; }
+inline void store(float* p, Lanes v) { *p = v; }
+inline Lanes add(Lanes a, Lanes b) { return a + b; }
+inline Lanes mul(Lanes a, Lanes b) { return a * b; }
+inline Lanes div(Lanes a, Lanes b) { return a / b; }
+inline Lanes clamp(Lanes v, Lanes lo, Lanes hi) { return std::min(std::max(v, lo), hi); }
+#endif
+
+static_assert(BRAIN_LANES % LANE_WIDTH == 0, "a block splits into whole vectors");
+
+// Padé approximant of tanh, exact at 0 and reaching +-1 at +-3. Unlike
+// std::tanh it vectorises and rounds the same on every platform.
+inline Lanes activate(Lanes x) {
+    x = clamp(x, broadcast(-3.0f), broadcast(3.0f));
+    Lanes x2 = mul(x, x);
+    return div(mul(x, add(broadcast(27.0f), x2)), add(broadcast(27.0f), mul(broadcast(9.0f), x2)));
+}
+
+// The same for 32-bit integer lanes, used by quantized brains. Every factor
+// the fixed-point kernel multiplies fits in 16 bits (genes, and activations
+// and inputs of at most 2 in Q12), which lets mul() use the cheap 16-bit
+// multiply-add. SSE2 has no 32-bit min or sign-extending loads, so those
+// are built from what it has.
+#if defined(__AVX2__)
+using IntLanes = __m256i;
+constexpr int INT_LANE_WIDTH = 8;
+inline IntLanes load_genes(const int8_t* p) { return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))); }
+inline IntLanes load_genes(const int16_t* p) { return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+inline IntLanes load_ints(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline void store_ints(int32_t* p, IntLanes v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline IntLanes broadcast_int(int32_t v) { return _mm256_set1_epi32(v); }
+inline IntLanes add(IntLanes a, IntLanes b) { return _mm256_add_epi32(a, b); }
+inline IntLanes sub(IntLanes a, IntLanes b) { return _mm256_sub_epi32(a, b); }
+// Product of lanes that fit in 16 bits: with the high half of `a` cleared,
+// the pair-wise multiply-add leaves exactly a * b in each 32-bit lane
+inline IntLanes mul(IntLanes a, IntLanes b) { return _mm256_madd_epi16(_mm256_and_si256(a, _mm256_set1_epi32(0xFFFF)), b); }
+template <int Bits> IntLanes shift_left(IntLanes v) { return _mm256_slli_epi32(v, Bits); }
+template <int Bits> IntLanes shift_right(IntLanes v) { return _mm256_srai_epi32(v, Bits); }
+inline IntLanes minimum(IntLanes a, IntLanes b) { return _mm256_min_epi32(a, b); }
+inline IntLanes absolute(IntLanes v) { return _mm256_abs_epi32(v); }
+// y with the sign of x; y is 0 wherever x is
+inline IntLanes copy_sign(IntLanes y, IntLanes x) { return _mm256_sign_epi32(y, x); }
+#elif defined(SIMWORLD_SSE2)
+using IntLanes = __m128i;
+constexpr int INT_LANE_WIDTH = 4;
+inline IntLanes load_genes(const int8_t* p) {
+    int32_t bytes;
+    std::memcpy(&bytes, p, sizeof(bytes));
+    __m128i v = _mm_cvtsi32_si128(bytes);
+    v = _mm_unpacklo_epi8(v, v);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 24);
+}
+inline IntLanes load_genes(const int16_t* p) {
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+inline IntLanes load_ints(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void store_ints(int32_t* p, IntLanes v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline IntLanes broadcast_int(int32_t v) { return _mm_set1_epi32(v); }
+inline IntLanes add(IntLanes a, IntLanes b) { return _mm_add_epi32(a, b); }
+inline IntLanes sub(IntLanes a, IntLanes b) { return _mm_sub_epi32(a, b); }
+inline IntLanes mul(IntLanes a, IntLanes b) { return _mm_madd_epi16(_mm_and_si128(a, _mm_set1_epi32(0xFFFF)), b); }
+template <int Bits> IntLanes shift_left(IntLanes v) { return _mm_slli_epi32(v, Bits); }
+template <int Bits> IntLanes shift_right(IntLanes v) { return _mm_srai_epi32(v, Bits); }
+inline IntLanes minimum(IntLanes a, IntLanes b) {
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+}
+inline IntLanes copy_sign(IntLanes y, IntLanes x) {
+    __m128i sign = _mm_srai_epi32(x, 31);
+    return _mm_sub_epi32(_mm_xor_si128(y, sign), sign);
+}
+inline IntLanes absolute(IntLanes v) { return copy_sign(v, v); }
+#else
+using IntLanes = int32_t;
+constexpr int INT_LANE_WIDTH = 1;
+template <typename Gene> IntLanes load_genes(const Gene* p) { return *p; }
+inline IntLanes load_ints(const int32_t* p) { return *p; }
+inline void store_ints(int32_t* p, IntLanes v) { *p = v; }
+inline IntLanes broadcast_int(int32_t v) { return v; }
+inline IntLanes add(IntLanes a, IntLanes b) { return a + b; }
+inline IntLanes sub(IntLanes a, IntLanes b) { return a - b; }
+inline IntLanes mul(IntLanes a, IntLanes b) { return a * b; }
+template <int Bits> IntLanes shift_left(IntLanes v) { return v * (1 << Bits); }
+template <int Bits> IntLanes shift_right(IntLanes v) { return v >> Bits; }
+inline IntLanes minimum(IntLanes a, IntLanes b) { return std::min(a, b); }
+inline IntLanes copy_sign(IntLanes y, IntLanes x) { return x < 0 ? -y : y; }
+inline IntLanes absolute(IntLanes v) { return v < 0 ? -v : v; }
+#endif
+
+static_assert(BRAIN_LANES % INT_LANE_WIDTH == 0, "a block splits into whole vectors");
+
+// Fixed-point activations and inputs, Q12
+constexpr int ACTIVATION_BITS = 12;
+constexpr int32_t ACTIVATION_ONE = 1 << ACTIVATION_BITS;
+
+inline int32_t to_fixed(float value) {
+    float scaled = value * ACTIVATION_ONE;
+    return static_cast<int32_t>(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+}
+
+// tanh without division: 1 - (1 - |x|/3)^3 with the sign of x. Same slope
+// as tanh at 0, flat at +-3 and within 0.06 of it in between.
+inline IntLanes activate_fixed(IntLanes x) {
+    const IntLanes one = broadcast_int(ACTIVATION_ONE);
+    IntLanes magnitude = minimum(absolute(x), broadcast_int(3 * ACTIVATION_ONE));
+    IntLanes t = minimum(shift_right<ACTIVATION_BITS>(mul(magnitude, broadcast_int(1366))), one); // |x| / 3
+    IntLanes u = sub(one, t);
+    IntLanes cube = shift_right<ACTIVATION_BITS>(mul(shift_right<ACTIVATION_BITS>(mul(u, u)), u));
+    return copy_sign(sub(one, cube), x);
+}
+
+template <typename Gene>
+Gene random_gene(CounterRng& rng) {
+    if constexpr (std::is_floating_point<Gene>::value) {
+        return rng.next_float() * 2.0f - 1.0f;
+    } else {
+        constexpr int one = 1 << GeneFormat<Gene>::FRACTION_BITS;
+        return static_cast<Gene>(rng.next_int(-one, one));
     }
-    for (int j = 0; j < HIDDEN_SIZE; ++j) {
-        hidden[j] = activate(hidden[j] + biases1[j]);
+}
+
+template <typename Gene>
+Gene mutate_gene(Gene gene, CounterRng& rng) {
+    if constexpr (std::is_floating_point<Gene>::value) {
+        return gene + (rng.next_float() * 2.0f - 1.0f) * BRAIN_MUTATION_STEP;
+    } else {
+        // Whole steps of the fixed-point format, saturating at its range
+        constexpr int step = std::max(1, static_cast<int>(BRAIN_MUTATION_STEP * (1 << GeneFormat<Gene>::FRACTION_BITS)));
+        int value = gene + rng.next_int(-step, step);
+        value = std::min<int>(std::max<int>(value, std::numeric_limits<Gene>::min()), std::numeric_limits<Gene>::max());
+        return static_cast<Gene>(value);
     }
+}
 
-    // Hidden -> Output
-    std::vector<float> outputs(OUTPUT_SIZE, 0.0f);
-    for (int i = 0; i < HIDDEN_SIZE; ++i) {
-        for (int j = 0; j < OUTPUT_SIZE; ++j) {
-            outputs[j] += hidden[i] * weights2[i][j];
-        }
+} // namespace
+
+uint8_t decide_action(const BrainOutput& output) {
+    // Head for the strongest of the four moves, and go only if it fires
+    const float moves[4] = {output.move_up, output.move_right, output.move_down, output.move_left};
+    int direction = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (moves[i] > moves[direction]) direction = i;
+    }
+    uint8_t action = ACTION_DECIDED | static_cast<uint8_t>(direction);
+    if (moves[direction] > 0.0f) action |= ACTION_MOVE;
+    if (output.attack > 0.0f) action |= ACTION_ATTACK;
+    if (output.reproduce > 0.0f) action |= ACTION_REPRODUCE;
+    return action;
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::resize(uint32_t slots) {
+    Block empty;
+    empty.genes.fill(Gene());
+    blocks.resize((static_cast<size_t>(slots) + BRAIN_LANES - 1) / BRAIN_LANES, empty);
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::randomize(uint32_t slot, CounterRng& rng) {
+    for (int k = 0; k < GENOME_SIZE; ++k) {
+        gene(slot, k) = random_gene<Gene>(rng);
+    }
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::inherit(uint32_t child, uint32_t parent, CounterRng& rng, float rate) {
+    for (int k = 0; k < GENOME_SIZE; ++k) {
+        Gene value = gene(parent, k);
+        gene(child, k) = rng.chance(rate) ? mutate_gene(value, rng) : value;
+    }
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::get_genome(uint32_t slot, Gene* out) const {
+    for (int k = 0; k < GENOME_SIZE; ++k) {
+        out[k] = gene(slot, k);
+    }
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::set_genome(uint32_t slot, const Gene* in) {
+    for (int k = 0; k < GENOME_SIZE; ++k) {
+        gene(slot, k) = in[k];
+    }
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::compute_block(uint32_t block, const float* energy, const float* density,
+                                                             float sun_intensity, float outputs[Outputs][BRAIN_LANES]) const {
+    if constexpr (std::is_floating_point<Gene>::value) {
+        compute_float(blocks[block], energy, density, sun_intensity, outputs);
+    } else {
+        compute_fixed(blocks[block], energy, density, sun_intensity, outputs);
     }
-    for (int j = 0; j < OUTPUT_SIZE; ++j) {
-        outputs[j] = activate(outputs[j] + biases2[j]);
+}
+
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::compute_float(const Block& block, const float* energy, const float* density,
+                                                             float sun_intensity, float outputs[Outputs][BRAIN_LANES]) const {
+    if constexpr (std::is_same<Gene, float>::value) {
+        static_assert(Inputs == 3, "inputs are energy, density and sun intensity");
+        auto gene = [&](int k, int lane) { return load(block.genes.data() + k * BRAIN_LANES + lane); };
+        for (int lane = 0; lane < BRAIN_LANES; lane += LANE_WIDTH) {
+            const Lanes inputs[Inputs] = {load_unaligned(energy + lane), load_unaligned(density + lane),
+                                          broadcast(sun_intensity)};
+            // Input -> Hidden. All neurons of a layer accumulate side by
+            // side, so their dependency chains overlap.
+            Lanes hidden[Hidden];
+            for (int j = 0; j < Hidden; ++j) hidden[j] = gene(HIDDEN_BIASES + j, lane);
+            for (int i = 0; i < Inputs; ++i) {
+                for (int j = 0; j < Hidden; ++j) {
+                    hidden[j] = add(hidden[j], mul(inputs[i], gene(HIDDEN_WEIGHTS + i * Hidden + j, lane)));
+                }
+            }
+            for (int j = 0; j < Hidden; ++j) hidden[j] = activate(hidden[j]);
+            // Hidden -> Output
+            Lanes sums[Outputs];
+            for (int j = 0; j < Outputs; ++j) sums[j] = gene(OUTPUT_BIASES + j, lane);
+            for (int i = 0; i < Hidden; ++i) {
+                for (int j = 0; j < Outputs; ++j) {
+                    sums[j] = add(sums[j], mul(hidden[i], gene(OUTPUT_WEIGHTS + i * Outputs + j, lane)));
+                }
+            }
+            for (int j = 0; j < Outputs; ++j) store(outputs[j] + lane, activate(sums[j]));
+        }
     }
+}
 
-    return {outputs[0], outputs[1], outputs[2], outputs[3], outputs[4], outputs[5]};
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+void NeuralNet<Inputs, Hidden, Outputs, Gene>::compute_fixed(const Block& block, const float* energy, const float* density,
+                                                             float sun_intensity, float outputs[Outputs][BRAIN_LANES]) const {
+    static_assert(Inputs == 3, "inputs are energy, density and sun intensity");
+    // Each product is brought back to Q12 before it is summed, so sums stay
+    // far from overflow however wide the hidden layer gets
+    constexpr int weight_bits = GeneFormat<Gene>::FRACTION_BITS;
+    static_assert(weight_bits <= ACTIVATION_BITS, "biases are shifted up to Q12");
+    if constexpr (!std::is_floating_point<Gene>::value) {
+        auto gene = [&](int k, int lane) { return load_genes(block.genes.data() + k * BRAIN_LANES + lane); };
+        int32_t inputs[Inputs][BRAIN_LANES];
+        const int32_t sun = to_fixed(sun_intensity);
+        for (int lane = 0; lane < BRAIN_LANES; ++lane) {
+            inputs[0][lane] = to_fixed(energy[lane]);
+            inputs[1][lane] = to_fixed(density[lane]);
+            inputs[2][lane] = sun;
+        }
+        for (int lane = 0; lane < BRAIN_LANES; lane += INT_LANE_WIDTH) {
+            // Input -> Hidden, all neurons side by side as in compute_float
+            IntLanes hidden[Hidden];
+            for (int j = 0; j < Hidden; ++j) {
+                hidden[j] = shift_left<ACTIVATION_BITS - weight_bits>(gene(HIDDEN_BIASES + j, lane));
+            }
+            for (int i = 0; i < Inputs; ++i) {
+                const IntLanes input = load_ints(inputs[i] + lane);
+                for (int j = 0; j < Hidden; ++j) {
+                    IntLanes product = mul(input, gene(HIDDEN_WEIGHTS + i * Hidden + j, lane));
+                    hidden[j] = add(hidden[j], shift_right<weight_bits>(product));
+                }
+            }
+            for (int j = 0; j < Hidden; ++j) hidden[j] = activate_fixed(hidden[j]);
+            // Hidden -> Output
+            IntLanes sums[Outputs];
+            for (int j = 0; j < Outputs; ++j) {
+                sums[j] = shift_left<ACTIVATION_BITS - weight_bits>(gene(OUTPUT_BIASES + j, lane));
+            }
+            for (int i = 0; i < Hidden; ++i) {
+                for (int j = 0; j < Outputs; ++j) {
+                    IntLanes product = mul(hidden[i], gene(OUTPUT_WEIGHTS + i * Outputs + j, lane));
+                    sums[j] = add(sums[j], shift_right<weight_bits>(product));
+                }
+            }
+            for (int j = 0; j < Outputs; ++j) {
+                int32_t activations[INT_LANE_WIDTH];
+                store_ints(activations, activate_fixed(sums[j]));
+                // Exact in a float: an activation has at most 13 significant bits
+                for (int k = 0; k < INT_LANE_WIDTH; ++k) {
+                    outputs[j][lane + k] = static_cast<float>(activations[k]) / ACTIVATION_ONE;
+                }
+            }
+        }
+    }
 }
 
-void NeuralNet::mutate(float mutation_rate) {
-    std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
-    std::bernoulli_distribution mutate_dist(mutation_rate);
+template <int Inputs, int Hidden, int Outputs, typename Gene>
+BrainOutput NeuralNet<Inputs, Hidden, Outputs, Gene>::compute(uint32_t slot, const BrainInput& input) const {
+    static_assert(Outputs == 6, "outputs are four moves, attack and reproduce");
+    alignas(32) float energy[BRAIN_LANES], density[BRAIN_LANES];
+    std::fill_n(energy, BRAIN_LANES, input.energy);
+    std::fill_n(density, BRAIN_LANES, input.density);
+    float outputs[Outputs][BRAIN_LANES];
+    compute_block(slot / BRAIN_LANES, energy, density, input.sun_intensity, outputs);
+    const int lane = slot % BRAIN_LANES;
+    return {outputs[0][lane], outputs[1][lane], outputs[2][lane], outputs[3][lane], outputs[4][lane], outputs[5][lane]};
+}
 
-    for (auto& row : weights1) for (auto& w : row) if (mutate_dist(rng)) w += dist(rng);
-    for (auto& row : weights2) for (auto& w : row) if (mutate_dist(rng)) w += dist(rng);
-    for (auto& b : biases1) if (mutate_dist(rng)) b += dist(rng);
-    for (auto& b : biases2) if (mutate_dist(rng)) b += dist(rng);
-}
\ No newline at end of file
+template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, float>;
+template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, int16_t>;
+template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, int8_t>;
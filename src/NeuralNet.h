@@ -1,7 +1,13 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
-#include <random>
+#include "AlignedAllocator.h"
+#include "Random.h"
+#include "Types.h"
 
 struct BrainInput {
     float energy;        // Energy / max_energy
@@ -18,21 +24,112 @@ struct BrainOutput {
     float reproduce;
 };
 
+inline BrainInput make_brain_input(float energy, int density, float sun_intensity, float max_energy) {
+    return {energy / max_energy, static_cast<float>(density) / 8.0f, sun_intensity};
+}
+
+constexpr int BRAIN_INPUTS = 3;  // energy, density, sun_intensity
+constexpr int BRAIN_HIDDEN = 6;  // 6 hidden neurons
+constexpr int BRAIN_OUTPUTS = 6; // 4 moves, attack, reproduce
+constexpr int BRAIN_LANES = 8; // Brains evaluated together, one AVX register
+constexpr float BRAIN_MUTATION_RATE = 0.05f; // Chance of each gene changing at birth
+constexpr float BRAIN_MUTATION_STEP = 0.1f;  // Largest change of a mutated gene
+
+// A brain's decision for the tick, packed into one byte
+constexpr uint8_t ACTION_DIRECTION = 0x03; // 0: up, 1: right, 2: down, 3: left
+constexpr uint8_t ACTION_MOVE = 0x04;
+constexpr uint8_t ACTION_ATTACK = 0x08;
+constexpr uint8_t ACTION_REPRODUCE = 0x10;
+constexpr uint8_t ACTION_DECIDED = 0x80; // Set by the batch evaluation of the current tick
+
+uint8_t decide_action(const BrainOutput& output);
+
+// How a gene type stores a real weight. Quantized genes are fixed point with
+// FRACTION_BITS fractional bits; their brains run on integers with
+// activations in Q12.
+template <typename Gene>
+struct GeneFormat;
+
+template <>
+struct GeneFormat<float> {
+    static constexpr int FRACTION_BITS = 0;
+};
+
+template <>
+struct GeneFormat<int16_t> {
+    static constexpr int FRACTION_BITS = 12; // Weights in [-8, 8)
+};
+
+template <>
+struct GeneFormat<int8_t> {
+    static constexpr int FRACTION_BITS = 5; // Weights in [-4, 4)
+};
+
+// Brains of every OrganismPool slot for an Inputs -> Hidden -> Outputs
+// network. Genes are stored in blocks of BRAIN_LANES slots, gene-major
+// inside a block (gene k of slots 8b..8b+7 is contiguous), so one load
+// fetches a gene for eight brains and a block is evaluated with no
+// shuffling. Float genes run on AVX or SSE; every path computes the same
+// operations in the same order, so results are bit-identical with AVX, SSE
+// or plain floats. Integer genes run on exact fixed-point arithmetic.
+//
+// Members are defined in NeuralNet.cpp, which instantiates the topology
+// below for every gene type.
+template <int Inputs, int Hidden, int Outputs, typename Gene>
 class NeuralNet {
+public:
+    using GeneType = Gene;
+    // Genes of one brain: input -> hidden weights, hidden biases,
+    // hidden -> output weights, output biases
+    static constexpr int HIDDEN_WEIGHTS = 0;
+    static constexpr int HIDDEN_BIASES = HIDDEN_WEIGHTS + Inputs * Hidden;
+    static constexpr int OUTPUT_WEIGHTS = HIDDEN_BIASES + Hidden;
+    static constexpr int OUTPUT_BIASES = OUTPUT_WEIGHTS + Hidden * Outputs;
+    static constexpr int GENOME_SIZE = OUTPUT_BIASES + Outputs;
+
 private:
-    std::vector<std::vector<float>> weights1; // Input -> Hidden
-    std::vector<std::vector<float>> weights2; // Hidden -> Output
-    std::vector<float> biases1;               // Hidden layer biases
-    std::vector<float> biases2;               // Output layer biases
-    static constexpr int INPUT_SIZE = 3;       // energy, density, sun_intensity
-    static constexpr int HIDDEN_SIZE = 6;     // 6 hidden neurons
-    static constexpr int OUTPUT_SIZE = 6;      // 4 moves, attack, reproduce
-    std::mt19937 rng;
+    struct alignas(32) Block {
+        std::array<Gene, GENOME_SIZE * BRAIN_LANES> genes;
+    };
+    std::vector<Block, AlignedAllocator<Block, alignof(Block)>> blocks;
 
-    float activate(float x) const { return std::tanh(x); }
+    Gene& gene(uint32_t slot, int k) { return blocks[slot / BRAIN_LANES].genes[k * BRAIN_LANES + slot % BRAIN_LANES]; }
+    Gene gene(uint32_t slot, int k) const { return blocks[slot / BRAIN_LANES].genes[k * BRAIN_LANES + slot % BRAIN_LANES]; }
+    void compute_float(const Block& block, const float* energy, const float* density, float sun_intensity,
+                       float outputs[Outputs][BRAIN_LANES]) const;
+    void compute_fixed(const Block& block, const float* energy, const float* density, float sun_intensity,
+                       float outputs[Outputs][BRAIN_LANES]) const;
 
 public:
-    NeuralNet();
-    BrainOutput compute(const BrainInput& input) const;
-    void mutate(float mutation_rate = 0.05f);
-};
\ No newline at end of file
+    void resize(uint32_t slots);
+    void clear() { blocks.clear(); }
+
+    // Fresh random brain for an organism placed in the world
+    void randomize(uint32_t slot, CounterRng& rng);
+    // Parent's brain with each gene mutated with probability `rate`
+    void inherit(uint32_t child, uint32_t parent, CounterRng& rng, float rate = BRAIN_MUTATION_RATE);
+    void get_genome(uint32_t slot, Gene* out) const;
+    void set_genome(uint32_t slot, const Gene* in);
+
+    // Outputs of the BRAIN_LANES brains of `block` for per-lane inputs
+    // (energy and density arrays of BRAIN_LANES floats each)
+    void compute_block(uint32_t block, const float* energy, const float* density, float sun_intensity,
+                       float outputs[Outputs][BRAIN_LANES]) const;
+    // One brain on its own, through the same kernel
+    BrainOutput compute(uint32_t slot, const BrainInput& input) const;
+};
+
+// Weight storage, chosen at build time (SIMWORLD_BRAIN_GENE in CMake)
+#if defined(SIMWORLD_BRAIN_FLOAT)
+using BrainGene = float;
+#elif defined(SIMWORLD_BRAIN_INT16)
+using BrainGene = int16_t;
+#else
+using BrainGene = int8_t;
+#endif
+
+using Brain = NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, BrainGene>;
+
+extern template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, float>;
+extern template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, int16_t>;
+extern template class NeuralNet<BRAIN_INPUTS, BRAIN_HIDDEN, BRAIN_OUTPUTS, int8_t>;
@@ -0,0 +1,103 @@
+#include "Occupancy.h"
+#include <algorithm>
+
+void Occupancy::reset(int width, int height, int stride, int padding, bool wrap, const int* neighbor_offsets) {
+    this->width = width;
+    this->height = height;
+    this->stride = stride;
+    this->padding = padding;
+    this->wrap = wrap;
+    std::copy(neighbor_offsets, neighbor_offsets + 8, this->neighbor_offsets);
+    words_per_row = (width + 63) / 64;
+    bits.assign(static_cast<size_t>(words_per_row) * height, 0);
+    active.assign(bits.size(), 0);
+    const int chunk_rows = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    active_chunks = std::vector<std::atomic<uint32_t>>(static_cast<size_t>(chunk_rows) * words_per_row);
+    carnivorous.assign(bits.size(), 0);
+    density.assign(static_cast<size_t>(stride) * (height + 2 * padding), 0);
+}
+
+void Occupancy::add(int x, int y, int index) {
+    bits[word_index(x, y)] |= uint64_t(1) << (x & 63);
+    adjust_neighbors(x, y, index, 1);
+}
+
+void Occupancy::remove(int x, int y, int index) {
+    bits[word_index(x, y)] &= ~(uint64_t(1) << (x & 63));
+    adjust_neighbors(x, y, index, -1);
+}
+
+void Occupancy::adjust_neighbors(int x, int y, int index, int delta) {
+    bool interior = x > 0 && x < width - 1 && y > 0 && y < height - 1;
+    if (interior || !wrap) {
+        // Without wrapping, counts spilling into the padding ring are never read
+        for (int i = 0; i < 8; ++i) {
+            density[index + neighbor_offsets[i]] += delta;
+        }
+        return;
+    }
+    // Edge of a wrapping world: update the counts of the real cells across the seam
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0) continue;
+            int nx = (x + dx + width) % width;
+            int ny = (y + dy + height) % height;
+            density[(ny + padding) * stride + (nx + padding)] += delta;
+        }
+    }
+}
+
+// Bit-sliced neighbour count for one row: every cell of the row gets the sum
+// of its 8 neighbour bits, stored as 4 bit planes per 64-cell word.
+void Occupancy::row_neighbor_counts(int y, uint64_t* planes) const {
+    const uint64_t* rows[3];
+    for (int r = 0; r < 3; ++r) {
+        int ny = y + r - 1;
+        if (wrap) ny = (ny + height) % height;
+        rows[r] = (ny >= 0 && ny < height) ? row_bits(ny) : nullptr;
+    }
+    const int last = words_per_row - 1;
+    const int last_bit = (width - 1) & 63;
+
+    for (int k = 0; k < words_per_row; ++k) {
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        auto accumulate = [&](uint64_t v) {
+            uint64_t c = s0 & v; s0 ^= v; v = c;
+            c = s1 & v; s1 ^= v; v = c;
+            c = s2 & v; s2 ^= v; s3 |= c;
+        };
+        for (int r = 0; r < 3; ++r) {
+            if (!rows[r]) continue;
+            const uint64_t* row = rows[r];
+            // Cell x sees bit x-1 in `west` and bit x+1 in `east`
+            uint64_t carry_in = k > 0 ? row[k - 1] >> 63 : (wrap ? (row[last] >> last_bit) & 1 : 0);
+            uint64_t west = (row[k] << 1) | carry_in;
+            uint64_t east = (row[k] >> 1) | (k < last ? row[k + 1] << 63 : 0);
+            if (k == last && wrap) east |= (row[0] & 1) << last_bit;
+            accumulate(west);
+            accumulate(east);
+            if (r != 1) accumulate(row[k]);
+        }
+        planes[4 * k + 0] = s0;
+        planes[4 * k + 1] = s1;
+        planes[4 * k + 2] = s2;
+        planes[4 * k + 3] = s3;
+    }
+}
+
+void Occupancy::rebuild() {
+    std::fill(density.begin(), density.end(), 0);
+    std::vector<uint64_t> planes(4 * static_cast<size_t>(words_per_row));
+    for (int y = 0; y < height; ++y) {
+        row_neighbor_counts(y, planes.data());
+        uint8_t* out = density.data() + (y + padding) * stride + padding;
+        for (int k = 0; k < words_per_row; ++k) {
+            const uint64_t* p = &planes[4 * k];
+            int count = std::min(64, width - 64 * k);
+            for (int b = 0; b < count; ++b) {
+                out[64 * k + b] = static_cast<uint8_t>(((p[0] >> b) & 1) | (((p[1] >> b) & 1) << 1) |
+                                                       (((p[2] >> b) & 1) << 2) | (((p[3] >> b) & 1) << 3));
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline int count_trailing_zeros(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Occupancy of the grid mirrored as packed bitboards (64 cells per word,
+// row-major, no padding) plus a per-cell count of occupied neighbours.
+// The counts share Field's padded cell indexing, so a density query is a
+// single byte load. add()/remove() keep both layers current; rebuild()
+// recomputes all counts from the bitboards a row at a time.
+//
+// A second bitboard marks the cells whose organism is awake; Field::tick
+// only visits those, see Field::make_dormant(). A third marks carnivores,
+// so VisionMap can count each type from bitboards alone.
+//
+// The active bitboard is also summarised per chunk of CHUNK_SIZE x CHUNK_SIZE
+// cells: the number of its words that have any bit set. A tick skips chunks
+// whose count is zero without reading their words, so the time it spends
+// visiting cells follows the awake part of the world rather than its area.
+// Chunks only summarise; the bitboards and every per-cell grid still cover
+// the whole world.
+constexpr int CHUNK_SIZE = 64; // One bitboard word wide
+
+class Occupancy {
+private:
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> active;
+    // Words of `active` with a bit set, per chunk. A word is only written by
+    // the tile worker that owns it, but a chunk can span rows of tiles that
+    // run at once, so the counts themselves are shared.
+    std::vector<std::atomic<uint32_t>> active_chunks;
+    std::vector<uint64_t> carnivorous;
+    std::vector<uint8_t> density;
+    int width = 0, height = 0, stride = 0, padding = 0;
+    int words_per_row = 0;
+    bool wrap = false;
+    int neighbor_offsets[8];
+
+    void adjust_neighbors(int x, int y, int index, int delta);
+    void row_neighbor_counts(int y, uint64_t* planes) const;
+
+public:
+    void reset(int width, int height, int stride, int padding, bool wrap, const int* neighbor_offsets);
+    void add(int x, int y, int index);
+    void remove(int x, int y, int index);
+    void rebuild();
+    // Sets a cell's bit alone; call rebuild() once every cell is placed
+    void place(int x, int y) { bits[word_index(x, y)] |= uint64_t(1) << (x & 63); }
+    void set_active(int x, int y) {
+        uint64_t& word = active[word_index(x, y)];
+        if (!word) active_chunks[chunk_index(x, y)].fetch_add(1, std::memory_order_relaxed);
+        word |= uint64_t(1) << (x & 63);
+    }
+    void clear_active(int x, int y) {
+        uint64_t& word = active[word_index(x, y)];
+        if (!word) return;
+        word &= ~(uint64_t(1) << (x & 63));
+        if (!word) active_chunks[chunk_index(x, y)].fetch_sub(1, std::memory_order_relaxed);
+    }
+    void set_carnivorous(int x, int y, bool carnivore) {
+        uint64_t bit = uint64_t(1) << (x & 63);
+        uint64_t& word = carnivorous[word_index(x, y)];
+        word = carnivore ? word | bit : word & ~bit;
+    }
+
+    size_t word_index(int x, int y) const { return static_cast<size_t>(y) * words_per_row + (x >> 6); }
+    size_t chunk_index(int x, int y) const { return static_cast<size_t>(y / CHUNK_SIZE) * words_per_row + (x >> 6); }
+    bool is_occupied(int x, int y) const { return (bits[word_index(x, y)] >> (x & 63)) & 1; }
+    bool is_active(int x, int y) const { return (active[word_index(x, y)] >> (x & 63)) & 1; }
+    int get_density(int index) const { return density[index]; }
+    // Counts of consecutive cells of a row, starting at padded `index`
+    const uint8_t* density_row(int index) const { return density.data() + index; }
+    const uint64_t* row_bits(int y) const { return bits.data() + static_cast<size_t>(y) * words_per_row; }
+    const uint64_t* active_row_bits(int y) const { return active.data() + static_cast<size_t>(y) * words_per_row; }
+    const uint64_t* carnivorous_row_bits(int y) const { return carnivorous.data() + static_cast<size_t>(y) * words_per_row; }
+    // Whether the chunk holding word `k` of row `y` has any awake organism
+    bool is_chunk_active(int k, int y) const {
+        return active_chunks[chunk_index(k << 6, y)].load(std::memory_order_relaxed) != 0;
+    }
+    int get_words_per_row() const { return words_per_row; }
+};
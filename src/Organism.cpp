@@ -1,146 +1,228 @@
 #include "Organism.h"
+#include "Evolution.h"
 #include "Field.h"
-#include <random>
+#include "Profiler.h"
 #include <algorithm>
+#include <cmath>
 
-Organism::Organism(int x, int y, OrganismType type)
-    : x(x), y(y), energy(50.0f), type(type), direction(rand() % 4), age(0), rng(std::random_device{}()) {
+Organism::Organism(Field& field, OrganismId id, ChangeLog& changes)
+    : field(field), pool(field.get_pool()), id(id), changes(changes), rng(field.get_seed(), field.get_tick_count(), pool.uid[id]) {}
+
+OrganismId Organism::spawn(Field& field, int x, int y, OrganismType type, ChangeLog& changes) {
+    OrganismPool& pool = field.get_pool();
+    OrganismId id = pool.allocate();
+    pool.uid[id] = field.next_spawn_uid();
+    CounterRng rng(field.get_seed(), field.get_tick_count(), pool.uid[id]);
+    pool.x[id] = x;
+    pool.y[id] = y;
+    pool.energy[id] = 50.0f;
+    pool.age[id] = 0;
+    pool.type[id] = type;
+    pool.direction[id] = static_cast<uint8_t>(rng.next_int(4));
+    pool.birth_tick[id] = field.get_tick_count();
+    pool.last_tick[id] = field.get_tick_count();
     if (type == OrganismType::Photosynthetic) {
-        color = Color(0, 255, 0); // Green
+        pool.color[id] = PHOTOSYNTHETIC_COLOR;
     } else {
-        color = Color(255, 0, 0); // Red
+        pool.color[id] = CARNIVOROUS_COLOR;
     }
     for (int i = 0; i < MUTATION_MARKERS_COUNT; ++i) {
-        mutation_markers[i] = std::uniform_int_distribution<int>(0, 1000)(rng);
+        pool.mutation_markers[id][i] = rng.next_int(0, 1000);
     }
+    if (pool.has_brains()) pool.brains.randomize(id, rng);
+    pool.founder[id] = pool.mutation_markers[id];
+    pool.species[id] = species_key(pool.founder[id]);
+    changes.species.push_back({pool.species[id], pool.founder[id], 1});
+    changes.stats.add(type, pool.energy[id], pool.birth_tick[id]);
+    changes.record(EventType::Spawn, x, y, static_cast<int>(type));
+    field.set_organism(x, y, id);
+    return id;
 }
 
-Organism::Organism(const Organism& parent, int x, int y)
-    : x(x), y(y), energy(parent.energy * 0.5f), type(parent.type), direction(rand() % 4),
-      color(parent.color), age(0), rng(std::random_device{}()) {
-    std::copy(parent.mutation_markers, parent.mutation_markers + MUTATION_MARKERS_COUNT, mutation_markers);
-    change_marker();
+OrganismId Organism::spawn_child(Field& field, OrganismId parent, int x, int y, ChangeLog& changes) {
+    OrganismPool& pool = field.get_pool();
+    OrganismId id = pool.allocate();
+    // A parent gives birth at most once per tick, so (parent, tick) is unique
+    pool.uid[id] = hash_combine(pool.uid[parent], field.get_tick_count());
+    Organism child(field, id, changes);
+    pool.x[id] = x;
+    pool.y[id] = y;
+    pool.energy[id] = pool.energy[parent] * 0.5f;
+    pool.age[id] = 0;
+    pool.type[id] = pool.type[parent];
+    pool.direction[id] = static_cast<uint8_t>(child.rng.next_int(4));
+    pool.birth_tick[id] = field.get_tick_count();
+    pool.last_tick[id] = field.get_tick_count();
+    pool.color[id] = pool.color[parent];
+    pool.mutation_markers[id] = pool.mutation_markers[parent];
+    child.change_marker();
+    if (pool.has_brains()) pool.brains.inherit(id, parent, child.rng);
+    if (count_shared_markers(pool.mutation_markers[id], pool.founder[parent]) >= SPECIES_KINSHIP) {
+        pool.founder[id] = pool.founder[parent];
+        pool.species[id] = pool.species[parent];
+    } else {
+        pool.founder[id] = pool.mutation_markers[id];
+        pool.species[id] = species_key(pool.founder[id]);
+    }
+    changes.species.push_back({pool.species[id], pool.founder[id], 1});
+    changes.stats.add(pool.type[id], pool.energy[id], pool.birth_tick[id]);
+    ++changes.stats.births;
+    field.set_organism(x, y, id);
+    return id;
 }
 
-void Organism::photosynthesis(Field* field) {
-    if (type == OrganismType::Photosynthetic) {
-        float free_space = 8.0f - get_density(field); // 0 to 8 free cells
-        float rate = PHOTOSYNTHESIS_BASE_RATE * (free_space / 8.0f) * field->get_sun_intensity();
-        energy += rate;
-        if (energy > MAX_ENERGY) energy = MAX_ENERGY;
+void Organism::photosynthesis() {
+    PROFILE_SCOPE(Photosynthesis);
+    if (pool.type[id] == OrganismType::Photosynthetic) {
+        // With an environment the rate is already in the cell's growth map
+        float gain = field.has_environment() ? field.get_environment().harvest(pool.x[id], pool.y[id])
+                                             : photosynthesis_rate(field.get_density(cell()));
+        pool.energy[id] = std::min(pool.energy[id] + gain, field.get_rules().max_energy);
     }
 }
 
-void Organism::move(Field* field) {
+float Organism::photosynthesis_rate(int density) const {
+    float free_space = 8.0f - density; // 0 to 8 free cells
+    return field.get_rules().photosynthesis_base_rate * (free_space / 8.0f) * field.get_sun_intensity();
+}
+
+void Organism::move() {
+    PROFILE_SCOPE(Move);
     static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}; // up, right, down, left
-    int new_x = x + directions[direction][0];
-    int new_y = y + directions[direction][1];
-    if (field->is_in_bounds(new_x, new_y) && !field->get_organism(new_x, new_y)) {
-        field->set_organism(x, y, nullptr);
-        x = new_x;
-        y = new_y;
-        field->set_organism(x, y, this);
-        energy -= MOVE_COST;
+    int target = cell() + field.get_direction_offsets()[pool.direction[id]];
+    if (field.cell(target) == NO_ORGANISM) {
+        int new_x = pool.x[id] + directions[pool.direction[id]][0];
+        int new_y = pool.y[id] + directions[pool.direction[id]][1];
+        field.wrap_position(new_x, new_y);
+        changes.record(EventType::Move, pool.x[id], pool.y[id], pool.direction[id]);
+        field.set_organism(pool.x[id], pool.y[id], NO_ORGANISM);
+        pool.x[id] = new_x;
+        pool.y[id] = new_y;
+        field.set_organism(new_x, new_y, id);
+        pool.energy[id] -= field.get_rules().move_cost;
     }
 }
 
-void Organism::attack(Field* field) {
-    static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
-    int target_x = x + directions[direction][0];
-    int target_y = y + directions[direction][1];
-    Organism* neighbor = field->get_organism(target_x, target_y);
-    if (neighbor && neighbor->get_type() == OrganismType::Photosynthetic) {
-        energy += neighbor->get_energy();
-        if (energy > MAX_ENERGY) energy = MAX_ENERGY;
-        delete neighbor;
-        field->set_organism(target_x, target_y, nullptr);
-        energy -= ATTACK_COST;
+void Organism::attack() {
+    PROFILE_SCOPE(Attack);
+    OrganismId neighbor = field.cell(cell() + field.get_direction_offsets()[pool.direction[id]]);
+    if (neighbor < BORDER_CELL && pool.type[neighbor] == OrganismType::Photosynthetic) {
+        pool.energy[id] = std::min(pool.energy[id] + pool.energy[neighbor], field.get_rules().max_energy);
+        changes.record(EventType::Kill, pool.x[id], pool.y[id], pool.direction[id]);
+        field.kill_organism(neighbor, changes);
+        ++changes.stats.kills;
+        pool.energy[id] -= field.get_rules().attack_cost;
+    }
+}
+
+bool Organism::hunt() {
+    // Step down the distances to prey, and strike once next to it. The map
+    // is from the start of the tick: prey may have left, or the step be taken.
+    int direction = field.get_hunt().toward_prey(pool.x[id], pool.y[id]);
+    if (direction < 0) return false;
+    pool.direction[id] = static_cast<uint8_t>(direction);
+    if (field.get_hunt().get_distance(pool.x[id], pool.y[id]) == 1) {
+        attack();
+    } else {
+        move();
     }
+    return true;
 }
 
-void Organism::reproduce(Field* field) {
-    if (age < FERTILITY_DELAY || energy < REPRODUCE_COST) return;
+void Organism::reproduce() {
+    PROFILE_SCOPE(Reproduce);
+    const Rules& rules = field.get_rules();
+    if (pool.age[id] < rules.fertility_delay || pool.energy[id] < rules.reproduce_cost) return;
     static const int offsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
-    std::vector<int> free_cells;
+    const int* neighbor_offsets = field.get_neighbor_offsets();
+    const int here = cell();
+    int free_cells[8];
+    int free_count = 0;
     for (int i = 0; i < 8; ++i) {
-        int new_x = x + offsets[i][0];
-        int new_y = y + offsets[i][1];
-        if (field->is_in_bounds(new_x, new_y) && !field->get_organism(new_x, new_y)) {
-            free_cells.push_back(i);
+        if (field.cell(here + neighbor_offsets[i]) == NO_ORGANISM) {
+            free_cells[free_count++] = i;
         }
     }
-    if (!free_cells.empty()) {
-        int idx = free_cells[std::uniform_int_distribution<size_t>(0, free_cells.size() - 1)(rng)];
-        int new_x = x + offsets[idx][0];
-        int new_y = y + offsets[idx][1];
-        Organism* child = new Organism(*this, new_x, new_y);
+    if (free_count > 0) {
+        int idx = free_cells[rng.next_int(free_count)];
+        int new_x = pool.x[id] + offsets[idx][0];
+        int new_y = pool.y[id] + offsets[idx][1];
+        field.wrap_position(new_x, new_y);
+        const float density = get_density(); // Before the child counts as a neighbour
+        OrganismId child = spawn_child(field, id, new_x, new_y, changes);
+        changes.record(EventType::Birth, pool.x[id], pool.y[id], idx);
         // Chance to mutate child to carnivorous if density is high
-        if (type == OrganismType::Photosynthetic && get_density(field) >= 6.0f) {
-            float mutation_chance = DENSITY_MUTATION_FACTOR * get_density(field);
-            if (std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < mutation_chance) {
-                child->type = OrganismType::Carnivorous;
-                child->color = Color(255, 0, 0);
+        if (pool.type[id] == OrganismType::Photosynthetic && density >= 6.0f) {
+            float mutation_chance = rules.density_mutation_factor * density;
+            if (rng.chance(mutation_chance)) {
+                Organism(field, child, changes).become_carnivore();
             }
         }
-        field->add_organism(child);
-        energy -= REPRODUCE_COST;
+        pool.energy[id] -= rules.reproduce_cost;
     }
 }
 
-float Organism::get_density(Field* field) const {
-    int count = 0;
-    for (int dx = -1; dx <= 1; ++dx) {
-        for (int dy = -1; dy <= 1; ++dy) {
-            if (dx == 0 && dy == 0) continue;
-            if (field->get_organism(x + dx, y + dy)) ++count;
-        }
-    }
-    return static_cast<float>(count);
+Sight Organism::look_ahead(int direction, int radius) const {
+    return field.get_vision().ahead(pool.x[id], pool.y[id], direction, radius);
 }
 
-void Organism::mutate_type(Field* field) {
-    if (type == OrganismType::Photosynthetic && age >= FERTILITY_DELAY) {
-        float density = get_density(field);
-        if (density >= 6.0f && energy < 0.5f * MAX_ENERGY) {
-            float mutation_chance = DENSITY_MUTATION_FACTOR * density * (1.0f - energy / MAX_ENERGY);
-            if (std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < mutation_chance) {
-                type = OrganismType::Carnivorous;
-                color = Color(255, 0, 0);
-            }
+float Organism::get_density() const {
+    return static_cast<float>(field.get_density(cell()));
+}
+
+void Organism::mutate_type() {
+    PROFILE_SCOPE(MutateType);
+    if (pool.type[id] == OrganismType::Photosynthetic && pool.age[id] >= field.get_rules().fertility_delay) {
+        float chance = mutation_chance(field.get_density(cell()));
+        if (chance > 0.0f && rng.chance(chance)) {
+            become_carnivore();
         }
     }
 }
 
+float Organism::mutation_chance(int density) const {
+    const Rules& rules = field.get_rules();
+    float energy = pool.energy[id];
+    if (density < 6 || energy >= 0.5f * rules.max_energy) return 0.0f;
+    return rules.density_mutation_factor * density * (1.0f - energy / rules.max_energy);
+}
+
+void Organism::become_carnivore() {
+    changes.stats.change_type(pool.type[id], OrganismType::Carnivorous);
+    changes.record(EventType::Mutation, pool.x[id], pool.y[id]);
+    pool.type[id] = OrganismType::Carnivorous;
+    pool.color[id] = CARNIVOROUS_COLOR;
+    field.mark_carnivorous(pool.x[id], pool.y[id]);
+    field.mark_dirty(pool.x[id], pool.y[id]);
+}
+
 void Organism::change_marker() {
-    int idx = std::uniform_int_distribution<int>(0, MUTATION_MARKERS_COUNT - 1)(rng);
-    mutation_markers[idx] = std::uniform_int_distribution<int>(0, 1000)(rng);
+    int idx = rng.next_int(MUTATION_MARKERS_COUNT);
+    pool.mutation_markers[id][idx] = rng.next_int(0, 1000);
 }
 
-int Organism::find_kinship(const Organism* other) const {
-    int matches = 0;
-    for (int i = 0; i < MUTATION_MARKERS_COUNT; ++i) {
-        if (mutation_markers[i] == other->mutation_markers[i]) ++matches;
-    }
-    return matches;
+int Organism::find_kinship(const Organism& other) const {
+    return count_shared_markers(pool.mutation_markers[id], other.pool.mutation_markers[other.id]);
 }
 
-bool Organism::find_free_direction(Field* field, int& best_direction) const {
+bool Organism::find_free_direction(int& best_direction) const {
     static const int directions[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
-    float min_density = 9.0f; // More than max possible density (8)
+    const int* direction_offsets = field.get_direction_offsets();
+    const int here = cell();
+    int min_density = 9; // More than max possible density (8)
     best_direction = -1;
     for (int i = 0; i < 4; ++i) {
-        int new_x = x + directions[i][0];
-        int new_y = y + directions[i][1];
-        if (field->is_in_bounds(new_x, new_y) && !field->get_organism(new_x, new_y)) {
-            // Calculate density at new position
-            int count = 0;
-            for (int dx = -1; dx <= 1; ++dx) {
-                for (int dy = -1; dy <= 1; ++dy) {
-                    if (dx == 0 && dy == 0) continue;
-                    if (field->get_organism(new_x + dx, new_y + dy)) ++count;
-                }
+        int target = here + direction_offsets[i];
+        if (field.cell(target) == NO_ORGANISM) {
+            // Density at new position. Across the seam of a wrapping world the
+            // target is a padding image, so look up the real cell instead
+            if (field.is_wrapping()) {
+                int new_x = pool.x[id] + directions[i][0];
+                int new_y = pool.y[id] + directions[i][1];
+                field.wrap_position(new_x, new_y);
+                target = field.index_of(new_x, new_y);
             }
-            float density = static_cast<float>(count);
+            int density = field.get_density(target);
             if (density < min_density) {
                 min_density = density;
                 best_direction = i;
@@ -150,42 +232,113 @@ bool Organism::find_free_direction(Field* field, int& best_direction) const {
     return best_direction != -1;
 }
 
-void Organism::update(Field* field) {
-    ++age;
-    photosynthesis(field);
-    mutate_type(field);
+void Organism::update() {
+    const float initial_energy = pool.energy[id];
+    ++changes.stats.updates;
+    // Dormant organisms skip ticks; replay those before acting
+    uint32_t skipped = field.get_tick_count() - pool.last_tick[id] - 1;
+    bool mutation_due = pool.wake_tick[id] == field.get_tick_count();
+    pool.last_tick[id] = field.get_tick_count();
+    pool.wake_tick[id] = NO_WAKE;
+    if (skipped > 0) catch_up(skipped);
+    if (mutation_due) become_carnivore();
 
-    if (type == OrganismType::Photosynthetic) {
+    ++pool.age[id];
+    photosynthesis();
+    mutate_type();
+
+    if (pool.has_brains()) {
+        follow_brain();
+    } else if (pool.type[id] == OrganismType::Photosynthetic) {
         // Try to reproduce if enough energy
-        if (energy >= REPRODUCE_COST) {
-            reproduce(field);
+        if (pool.energy[id] >= field.get_rules().reproduce_cost) {
+            reproduce();
         }
         // If no free space for reproduction, move to a less dense area
-        else if (get_density(field) >= 6.0f) {
+        else if (get_density() >= 6.0f) {
             int best_direction;
-            if (find_free_direction(field, best_direction)) {
-                direction = best_direction;
-                move(field);
+            if (find_free_direction(best_direction)) {
+                pool.direction[id] = static_cast<uint8_t>(best_direction);
+                if (field.has_vision()) {
+                    // Head for open space further away if the first step is free
+                    Evo(field.get_vision_level()).HighView(this);
+                    if (field.cell(cell() + field.get_direction_offsets()[pool.direction[id]]) != NO_ORGANISM) {
+                        pool.direction[id] = static_cast<uint8_t>(best_direction);
+                    }
+                }
+                move();
             }
         }
-    } else {
-        // Carnivorous: attack if possible, otherwise move randomly
-        attack(field);
-        if (std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < 0.2f) { // 20% chance to move
-            direction = std::uniform_int_distribution<int>(0, 3)(rng);
-            move(field);
+    } else if (!field.is_hunting() || !hunt()) {
+        // Carnivorous with no prey in hunting range: attack if possible,
+        // otherwise move randomly, or towards prey when it can see far enough
+        attack();
+        if (rng.chance(0.2f)) { // 20% chance to move
+            pool.direction[id] = static_cast<uint8_t>(rng.next_int(4));
+            if (field.has_vision()) Evo(field.get_vision_level()).HighView(this);
+            move();
         }
     }
 
     // Die if energy <= 0 or too old || age >= 100
-    if (energy <= 0) {
-        field->set_organism(x, y, nullptr);
-        delete this;
+    // The slot stays reserved until the pool is flushed at the end of the tick
+    changes.stats.energy += pool.energy[id] - initial_energy;
+    if (pool.energy[id] <= 0) {
+        PROFILE_SCOPE(Death);
+        changes.record(EventType::Death, pool.x[id], pool.y[id]);
+        field.kill_organism(id, changes);
+    } else if (is_idle()) {
+        field.make_dormant(id, schedule_mutation());
     }
 }
 
-void Organism::draw(SDL_Renderer* renderer) const {
-    SDL_Rect rect = { FIELD_X + x * CELL_SIZE, FIELD_Y + y * CELL_SIZE, CELL_SIZE, CELL_SIZE };
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
-    SDL_RenderFillRect(renderer, &rect);
-}
\ No newline at end of file
+void Organism::follow_brain() {
+    uint8_t action = pool.action[id];
+    if (!(action & ACTION_DECIDED)) {
+        // Asleep when this tick's brains were evaluated: think on the spot
+        BrainInput input = make_brain_input(pool.energy[id], field.get_density(cell()), field.get_sun_intensity(),
+                                            field.get_rules().max_energy);
+        action = decide_action(pool.brains.compute(id, input));
+    }
+    pool.direction[id] = action & ACTION_DIRECTION;
+    if (pool.type[id] == OrganismType::Photosynthetic) {
+        if ((action & ACTION_REPRODUCE) && pool.energy[id] >= field.get_rules().reproduce_cost) {
+            reproduce();
+        } else if (action & ACTION_MOVE) {
+            move();
+        }
+    } else {
+        if (action & ACTION_ATTACK) attack();
+        if (action & ACTION_MOVE) move();
+    }
+}
+
+bool Organism::is_idle() const {
+    // A photosynthetic organism boxed in on all sides gains no energy and has
+    // no cell to reproduce or move into: until a neighbour leaves, a tick
+    // only ages it and rolls the constant chance of turning carnivorous.
+    // A brain sees the same inputs every such tick, so the same holds for it.
+    return pool.type[id] == OrganismType::Photosynthetic && field.get_density(cell()) == 8;
+}
+
+uint32_t Organism::schedule_mutation() {
+    // Draw the tick of the first successful mutation roll at once: the number
+    // of rolls until success is geometric. Rolls start at the fertility delay.
+    float chance = mutation_chance(8);
+    if (chance <= 0.0f) return NO_WAKE;
+    uint32_t now = field.get_tick_count();
+    uint64_t first_roll = now + std::max(1, field.get_rules().fertility_delay - pool.age[id]);
+    double u = 1.0 - rng.next_float(); // (0, 1]
+    double rolls = std::floor(std::log(u) / std::log1p(-static_cast<double>(chance)));
+    double tick = static_cast<double>(first_roll) + rolls;
+    return tick < static_cast<double>(NO_WAKE) ? static_cast<uint32_t>(tick) : NO_WAKE;
+}
+
+void Organism::catch_up(uint32_t ticks) {
+    // Closed form of `ticks` idle updates: age, plus photosynthesis at the
+    // fully boxed-in rate the organism had while asleep
+    pool.age[id] += static_cast<int>(ticks);
+    if (pool.type[id] == OrganismType::Photosynthetic) {
+        pool.energy[id] = std::min(pool.energy[id] + ticks * photosynthesis_rate(8), field.get_rules().max_energy);
+    }
+}
@@ -1,45 +1,56 @@
 #pragma once
 
-#include <SDL2/SDL.h>
 #include "Types.h"
+#include "OrganismPool.h"
+#include "Field.h"
+#include "Events.h"
 
-class Field;
-
-enum class OrganismType {
-    Photosynthetic,
-    Carnivorous
-};
-
+// Lightweight view over one organism's slot in the Field's OrganismPool.
+// Its only state is a random stream derived from (world seed, tick, uid),
+// so create one wherever an organism has to act.
 class Organism {
-private:
-    int x, y;
-    float energy;
-    OrganismType type;
+    friend class Bench; // Times the private steps, see Bench.cpp
 
-    int direction; // 0: up, 1: right, 2: down, 3: left
-    Color color;
-    int mutation_markers[MUTATION_MARKERS_COUNT];
-    int age;
-    std::mt19937 rng;
+private:
+    Field& field;
+    OrganismPool& pool;
+    OrganismId id;
+    ChangeLog& changes; // Where statistics and replay events are recorded
+    CounterRng rng; // Stream keyed by (world seed, tick, uid)
 
-    void photosynthesis(Field* field);
-    void move(Field* field);
-    void attack(Field* field);
-    void reproduce(Field* field);
-    float get_density(Field* field) const; //зрение
-    void mutate_type(Field* field);
+    void photosynthesis();
+    float photosynthesis_rate(int density) const;
+    bool is_idle() const;
+    void catch_up(uint32_t ticks);
+    uint32_t schedule_mutation();
+    float mutation_chance(int density) const;
+    void become_carnivore();
+    void move();
+    void attack();
+    bool hunt(); // Towards prey on the HuntMap; false if none is in range
+    void reproduce();
+    void follow_brain();
+    float get_density() const; //зрение
+    int cell() const { return field.index_of(pool.x[id], pool.y[id]); }
+    void mutate_type();
     void change_marker();
-    bool find_free_direction(Field* field, int& best_direction) const;
+    bool find_free_direction(int& best_direction) const;
 
 public:
-    Organism(int x, int y, OrganismType type = OrganismType::Photosynthetic);
-    Organism(const Organism& parent, int x, int y); // For reproduction
-    void update(Field* field);
-    void draw(SDL_Renderer* renderer) const;
-    int get_x() const { return x; }
-    int get_y() const { return y; }
-    float get_energy() const { return energy; }
-    OrganismType get_type() const { return type; }
-    const Color& get_color() const { return color; }
-    int find_kinship(const Organism* other) const;
-};
\ No newline at end of file
+    Organism(Field& field, OrganismId id, ChangeLog& changes);
+    static OrganismId spawn(Field& field, int x, int y, OrganismType type, ChangeLog& changes);
+    static OrganismId spawn_child(Field& field, OrganismId parent, int x, int y, ChangeLog& changes); // For reproduction
+    void update();
+    OrganismId get_id() const { return id; }
+    int get_x() const { return pool.x[id]; }
+    int get_y() const { return pool.y[id]; }
+    float get_energy() const { return pool.energy[id]; }
+    OrganismType get_type() const { return pool.type[id]; }
+    const Color& get_color() const { return pool.color[id]; }
+    int get_direction() const { return pool.direction[id]; }
+    void face(int direction) { pool.direction[id] = static_cast<uint8_t>(direction); }
+    // What lies up to `radius` cells ahead in `direction`, as of the start
+    // of the tick. Only while the Field has vision.
+    Sight look_ahead(int direction, int radius) const;
+    int find_kinship(const Organism& other) const;
+};
@@ -0,0 +1,113 @@
+#include "OrganismPool.h"
+#include <algorithm>
+
+OrganismId OrganismPool::allocate() {
+    if (free_count.load(std::memory_order_relaxed) == 0) {
+        // Only reachable outside a tick: Field reserves room before it starts
+        grow(capacity() + 1);
+    }
+    OrganismId id = free_slots[free_count.fetch_sub(1, std::memory_order_relaxed) - 1];
+    alive[id] = 1;
+    dormant[id] = 0;
+    wake_tick[id] = NO_WAKE;
+    live_count.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void OrganismPool::kill(OrganismId id) {
+    if (!is_alive(id)) return;
+    alive[id] = 0;
+    live_count.fetch_sub(1, std::memory_order_relaxed);
+    dead_slots[dead_count.fetch_add(1, std::memory_order_relaxed)] = id;
+}
+
+void OrganismPool::flush() {
+    uint32_t dead = dead_count.exchange(0, std::memory_order_relaxed);
+    uint32_t top = free_count.load(std::memory_order_relaxed);
+    for (uint32_t i = dead; i > 0; --i) {
+        free_slots[top++] = dead_slots[i - 1];
+    }
+    free_count.store(top, std::memory_order_relaxed);
+}
+
+void OrganismPool::clear() {
+    x.clear();
+    y.clear();
+    energy.clear();
+    age.clear();
+    type.clear();
+    direction.clear();
+    alive.clear();
+    last_tick.clear();
+    dormant.clear();
+    action.clear();
+    uid.clear();
+    birth_tick.clear();
+    wake_tick.clear();
+    color.clear();
+    mutation_markers.clear();
+    founder.clear();
+    species.clear();
+    brains.clear();
+    free_slots.clear();
+    dead_slots.clear();
+    free_count.store(0, std::memory_order_relaxed);
+    dead_count.store(0, std::memory_order_relaxed);
+    live_count.store(0, std::memory_order_relaxed);
+}
+
+void OrganismPool::reserve_free(uint32_t count) {
+    uint32_t available = free_count.load(std::memory_order_relaxed);
+    if (available < count) {
+        grow(capacity() + (count - available));
+    }
+}
+
+void OrganismPool::assign(uint32_t count) {
+    clear();
+    grow(count);
+    std::fill(alive.begin(), alive.end(), 1);
+    free_count.store(0, std::memory_order_relaxed);
+    live_count.store(count, std::memory_order_relaxed);
+}
+
+void OrganismPool::enable_brains(bool enabled) {
+    thinking = enabled;
+    brains.clear();
+    if (thinking) brains.resize(capacity());
+}
+
+void OrganismPool::grow(uint32_t new_capacity) {
+    // Grow geometrically so spawning one organism at a time stays cheap
+    new_capacity = std::max<uint32_t>(new_capacity, capacity() + capacity() / 2);
+    uint32_t old_capacity = capacity();
+    x.resize(new_capacity, 0);
+    y.resize(new_capacity, 0);
+    energy.resize(new_capacity, 0.0f);
+    age.resize(new_capacity, 0);
+    type.resize(new_capacity, OrganismType::Photosynthetic);
+    direction.resize(new_capacity, 0);
+    alive.resize(new_capacity, 0);
+    last_tick.resize(new_capacity, 0);
+    dormant.resize(new_capacity, 0);
+    action.resize(new_capacity, 0);
+    uid.resize(new_capacity, 0);
+    birth_tick.resize(new_capacity, 0);
+    wake_tick.resize(new_capacity, NO_WAKE);
+    color.resize(new_capacity);
+    mutation_markers.resize(new_capacity);
+    founder.resize(new_capacity);
+    species.resize(new_capacity, 0);
+    if (thinking) brains.resize(new_capacity);
+    free_slots.resize(new_capacity);
+    dead_slots.resize(new_capacity);
+
+    // New slots go under the existing free ones, lowest id on top
+    uint32_t added = new_capacity - old_capacity;
+    uint32_t top = free_count.load(std::memory_order_relaxed);
+    std::copy_backward(free_slots.begin(), free_slots.begin() + top, free_slots.begin() + top + added);
+    for (uint32_t i = 0; i < added; ++i) {
+        free_slots[i] = new_capacity - 1 - i;
+    }
+    free_count.store(top + added, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "NeuralNet.h"
+#include "Species.h"
+#include "Types.h"
+
+using OrganismId = uint32_t;
+constexpr OrganismId NO_ORGANISM = 0xFFFFFFFFu;
+constexpr uint32_t NO_WAKE = 0xFFFFFFFFu;
+
+// Structure-of-arrays store for every organism in the world.
+// Slots are addressed by stable OrganismId handles and recycled through a free
+// list. Killing an organism only marks it dead; its slot returns to the free
+// list in flush(), which Field calls once the tick is over.
+//
+// allocate() and kill() may run concurrently from tick workers as long as
+// reserve_free() made room beforehand: the arrays never grow mid-tick.
+class OrganismPool {
+public:
+    // Hot fields, swept every tick
+    std::vector<int> x, y;
+    std::vector<float> energy;
+    std::vector<int> age;
+    std::vector<OrganismType> type;
+    std::vector<uint8_t> direction; // 0: up, 1: right, 2: down, 3: left
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> last_tick; // Last tick the organism acted (or was born) in
+    std::vector<uint8_t> dormant;    // Asleep until its neighbourhood changes
+    std::vector<uint8_t> action;     // Brain decision for this tick, see ACTION_DECIDED
+
+    // Cold fields
+    std::vector<uint64_t> uid; // Keys the organism's random stream, see CounterRng
+    std::vector<uint32_t> birth_tick;
+    std::vector<uint32_t> wake_tick; // Scheduled mutation of a dormant organism, or NO_WAKE
+    std::vector<Color> color;
+    std::vector<std::array<int, MUTATION_MARKERS_COUNT>> mutation_markers;
+    std::vector<Markers> founder;    // Markers of the species' founder
+    std::vector<SpeciesKey> species; // species_key() of the founder
+    Brain brains; // Sized only while brains are enabled
+
+    OrganismId allocate();
+    void kill(OrganismId id);
+    void flush();
+    void clear();
+    void reserve_free(uint32_t count);
+    // Empties the pool and makes slots 0..count-1 live, fields unset: for
+    // callers that fill whole arrays at once, like checkpoint loading
+    void assign(uint32_t count);
+    void enable_brains(bool enabled);
+    bool has_brains() const { return thinking; }
+
+    bool is_alive(OrganismId id) const { return id < alive.size() && alive[id]; }
+    uint32_t size() const { return live_count.load(std::memory_order_relaxed); }
+    uint32_t capacity() const { return static_cast<uint32_t>(alive.size()); }
+
+private:
+    // Both stacks are sized to capacity() so pushes and pops never reallocate
+    std::vector<OrganismId> free_slots;
+    std::vector<OrganismId> dead_slots; // Killed this tick, released by flush()
+    std::atomic<uint32_t> free_count{0};
+    std::atomic<uint32_t> dead_count{0};
+    std::atomic<uint32_t> live_count{0};
+    bool thinking = false;
+
+    void grow(uint32_t count);
+};
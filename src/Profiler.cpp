@@ -0,0 +1,216 @@
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Trace storage per thread: chunks are allocated as the log grows and kept
+// for later captures, so a capture stops at TRACE_CHUNKS chunks
+constexpr uint64_t TRACE_CHUNK_EVENTS = 4096;
+constexpr uint64_t TRACE_CHUNKS = 256;
+
+static const char* ZONE_NAMES[PROFILE_ZONE_COUNT] = {
+    "Field::tick", "vision", "environment", "hunt", "think", "tile", "merge",
+    "photosynthesis", "mutate_type", "reproduce", "move", "attack", "death",
+    "Field::draw", "Main::draw_gui",
+};
+
+// Zones short and frequent enough to swamp a trace are only summed
+static const bool ZONE_TRACED[PROFILE_ZONE_COUNT] = {
+    true, true, true, true, true, true, true,
+    false, false, false, false, false, false,
+    true, true,
+};
+
+namespace {
+
+struct TraceEvent {
+    uint64_t start, end;
+    ProfileZone zone;
+};
+
+struct ThreadBuffer {
+    std::atomic<uint64_t> calls[PROFILE_ZONE_COUNT] = {};
+    std::atomic<uint64_t> nanos[PROFILE_ZONE_COUNT] = {};
+    std::atomic<TraceEvent*> chunks[TRACE_CHUNKS] = {};
+    std::atomic<uint32_t> capture{0}; // Capture the events belong to
+    std::atomic<uint64_t> events{0};  // Events written, each published by this count
+
+    // Guarded by the registry lock
+    std::string name = "thread";
+    bool owned = false;
+
+    ~ThreadBuffer() {
+        for (auto& chunk : chunks) delete[] chunk.load();
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<uint32_t> capture{0};
+    std::atomic<bool> capturing{false};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    // Never destroyed: threads may still record while statics are torn down
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+// Claims a buffer for the calling thread and returns it when the thread exits
+struct ThreadHandle {
+    ThreadBuffer* buffer = nullptr;
+
+    ThreadBuffer& get() {
+        if (!buffer) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (auto& candidate : r.buffers) {
+                if (!candidate->owned) {
+                    buffer = candidate.get();
+                    break;
+                }
+            }
+            if (!buffer) {
+                r.buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = r.buffers.back().get();
+            }
+            buffer->owned = true;
+        }
+        return *buffer;
+    }
+
+    ~ThreadHandle() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer->owned = false;
+    }
+};
+
+thread_local ThreadHandle local;
+
+// Only the owner writes a counter, so a load and a store make the increment
+void add(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+const char* profile_zone_name(ProfileZone zone) {
+    return ZONE_NAMES[static_cast<int>(zone)];
+}
+
+uint64_t Profiler::now() {
+    auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Profiler::record(ProfileZone zone, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = local.get();
+    const int i = static_cast<int>(zone);
+    add(buffer.calls[i], 1);
+    add(buffer.nanos[i], end - start);
+
+    Registry& r = registry();
+    if (!ZONE_TRACED[i] || !r.capturing.load(std::memory_order_relaxed)) return;
+    const uint32_t capture = r.capture.load(std::memory_order_relaxed);
+    if (buffer.capture.load(std::memory_order_relaxed) != capture) {
+        // First event of a new capture: empty the log before claiming it
+        buffer.events.store(0, std::memory_order_relaxed);
+        buffer.capture.store(capture, std::memory_order_release);
+    }
+    const uint64_t count = buffer.events.load(std::memory_order_relaxed);
+    if (count == TRACE_CHUNK_EVENTS * TRACE_CHUNKS) return;
+    std::atomic<TraceEvent*>& slot = buffer.chunks[count / TRACE_CHUNK_EVENTS];
+    TraceEvent* chunk = slot.load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new TraceEvent[TRACE_CHUNK_EVENTS];
+        slot.store(chunk, std::memory_order_relaxed);
+    }
+    chunk[count % TRACE_CHUNK_EVENTS] = {start, end, zone};
+    buffer.events.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::set_thread_name(const char* name) {
+    ThreadBuffer& buffer = local.get();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+void Profiler::get_totals(ProfileTotals& out) {
+    out = ProfileTotals();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& buffer : r.buffers) {
+        for (int i = 0; i < PROFILE_ZONE_COUNT; ++i) {
+            out.calls[i] += buffer->calls[i].load(std::memory_order_relaxed);
+            out.nanos[i] += buffer->nanos[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Profiler::start_capture() {
+    Registry& r = registry();
+    r.capture.fetch_add(1);
+    r.capturing.store(true);
+}
+
+void Profiler::stop_capture() {
+    registry().capturing.store(false);
+}
+
+bool Profiler::is_capturing() {
+    return registry().capturing.load();
+}
+
+uint64_t Profiler::get_captured_events() {
+    Registry& r = registry();
+    const uint32_t capture = r.capture.load();
+    uint64_t total = 0;
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& buffer : r.buffers) {
+        if (buffer->capture.load(std::memory_order_acquire) == capture) {
+            total += buffer->events.load(std::memory_order_acquire);
+        }
+    }
+    return total;
+}
+
+bool Profiler::write_trace(const std::string& path, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    // Complete events ("X") with times in microseconds; every buffer is a
+    // thread of one process. Events past the count read here may still be
+    // in the making, so they are left out.
+    Registry& r = registry();
+    const uint32_t capture = r.capture.load();
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char* separator = "\n";
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t tid = 0; tid < r.buffers.size(); ++tid) {
+        const ThreadBuffer& buffer = *r.buffers[tid];
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                     separator, tid, buffer.name.c_str());
+        separator = ",\n";
+        if (buffer.capture.load(std::memory_order_acquire) != capture) continue;
+        const uint64_t count = buffer.events.load(std::memory_order_acquire);
+        for (uint64_t k = 0; k < count; ++k) {
+            const TraceEvent& event = buffer.chunks[k / TRACE_CHUNK_EVENTS].load(std::memory_order_relaxed)[k % TRACE_CHUNK_EVENTS];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                         ZONE_NAMES[static_cast<int>(event.zone)], tid, event.start / 1000.0,
+                         (event.end - event.start) / 1000.0);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::fflush(file) == 0 && !std::ferror(file);
+    ok &= std::fclose(file) == 0;
+    if (!ok) error = "cannot write " + path;
+    return ok;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Timed sections of the hot path, see PROFILE_SCOPE
+enum class ProfileZone : int {
+    Tick,           // Field::tick
+    Vision,         // Rebuilding the vision map
+    Environment,    // Updating light and nutrients
+    Hunt,           // Updating the carnivores' distances to prey
+    Think,          // Evaluating the brains
+    Tile,           // Updating one tile of a phase
+    Merge,          // Merging the change logs of a phase
+    Photosynthesis, // Steps of Organism::update, summed but never traced:
+    MutateType,     // there are millions of them per second
+    Reproduce,
+    Move,
+    Attack,
+    Death,
+    Draw,           // Field::draw
+    DrawGui,        // Main::draw_gui
+    Count
+};
+constexpr int PROFILE_ZONE_COUNT = static_cast<int>(ProfileZone::Count);
+
+#if defined(SIMWORLD_PROFILE)
+constexpr bool PROFILER_ENABLED = true;
+#else
+constexpr bool PROFILER_ENABLED = false;
+#endif
+
+const char* profile_zone_name(ProfileZone zone);
+
+// Calls and time of every zone since the start, summed over all threads
+struct ProfileTotals {
+    uint64_t calls[PROFILE_ZONE_COUNT] = {};
+    uint64_t nanos[PROFILE_ZONE_COUNT] = {};
+};
+
+// Each thread records into a buffer of its own: running totals per zone and,
+// while a capture is on, a log of the traced zones for a Chrome trace. The
+// owner is the only writer, so recording takes no locks; readers see
+// published counts through atomics and never what is still being written.
+// Buffers are registered under a lock the first time a thread records and
+// handed to a later thread when their owner exits.
+class Profiler {
+public:
+    // Nanoseconds on a steady clock
+    static uint64_t now();
+    static void record(ProfileZone zone, uint64_t start, uint64_t end);
+    // Labels the calling thread in traces
+    static void set_thread_name(const char* name);
+
+    static void get_totals(ProfileTotals& out);
+
+    // A capture keeps the traced zones of every thread until stopped or
+    // about a million events per thread; starting one drops the last
+    static void start_capture();
+    static void stop_capture();
+    static bool is_capturing();
+    static uint64_t get_captured_events();
+    // The events of the last capture as Chrome trace JSON, for
+    // chrome://tracing or ui.perfetto.dev
+    static bool write_trace(const std::string& path, std::string& error);
+};
+
+// Times the rest of the enclosing scope. Compiles to nothing unless the
+// build sets SIMWORLD_PROFILE.
+class ProfileScope {
+private:
+    ProfileZone zone;
+    uint64_t start;
+
+public:
+    explicit ProfileScope(ProfileZone zone) : zone(zone), start(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(zone, start, Profiler::now()); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if defined(SIMWORLD_PROFILE)
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(ProfileZone::zone)
+#define PROFILE_THREAD(name) Profiler::set_thread_name(name)
+#else
+#define PROFILE_SCOPE(zone) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// SplitMix64 finaliser: a strong 64-bit mix, used both to derive keys and as
+// the output function of CounterRng.
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t hash_combine(uint64_t a, uint64_t b) {
+    return splitmix64(a ^ (splitmix64(b) + 0x632BE59BD9B4E019ull));
+}
+
+// Counter-based generator: the n-th value of a stream is a pure function of
+// (key, n), so a stream costs 16 bytes, needs no seeding syscall and can be
+// recreated anywhere from (seed, tick, organism id) for bit-exact replays.
+class CounterRng {
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+
+public:
+    CounterRng(uint64_t seed, uint64_t tick, uint64_t stream)
+        : key(hash_combine(hash_combine(seed, tick), stream)) {}
+
+    uint64_t next_u64() { return splitmix64(key + 0x9E3779B97F4A7C15ull * ++counter); }
+    uint32_t next_u32() { return static_cast<uint32_t>(next_u64() >> 32); }
+
+    // Uniform in [0, 1)
+    float next_float() { return static_cast<float>(next_u64() >> 40) * (1.0f / 16777216.0f); }
+
+    // Uniform in [0, n), n > 0 (Lemire's multiply-shift, bias below 2^-32)
+    int next_int(int n) { return static_cast<int>((static_cast<uint64_t>(next_u32()) * static_cast<uint32_t>(n)) >> 32); }
+
+    // Uniform in [lo, hi]
+    int next_int(int lo, int hi) { return lo + next_int(hi - lo + 1); }
+
+    bool chance(float probability) { return next_float() < probability; }
+};
@@ -0,0 +1,115 @@
+#include "Rules.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include "Hunting.h"
+
+const RuleInfo RULE_INFO[] = {
+    {"move_cost", &Rules::move_cost, nullptr},
+    {"attack_cost", &Rules::attack_cost, nullptr},
+    {"reproduce_cost", &Rules::reproduce_cost, nullptr},
+    {"photosynthesis_base_rate", &Rules::photosynthesis_base_rate, nullptr},
+    {"max_energy", &Rules::max_energy, nullptr},
+    {"density_mutation_factor", &Rules::density_mutation_factor, nullptr},
+    {"fertility_delay", nullptr, &Rules::fertility_delay},
+    {"initial_population", nullptr, &Rules::initial_population},
+    {"hunt_range", nullptr, &Rules::hunt_range},
+};
+const int RULE_COUNT = static_cast<int>(sizeof(RULE_INFO) / sizeof(RULE_INFO[0]));
+
+const RuleInfo* find_rule(const std::string& name) {
+    for (const RuleInfo& info : RULE_INFO) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+double get_rule(const Rules& rules, const RuleInfo& info) {
+    return info.real ? static_cast<double>(rules.*info.real) : static_cast<double>(rules.*info.integer);
+}
+
+bool set_rule(Rules& rules, const RuleInfo& info, const std::string& value, std::string& error) {
+    const char* begin = value.c_str();
+    char* end = nullptr;
+    errno = 0;
+    if (info.real) {
+        float parsed = std::strtof(begin, &end);
+        if (end != begin && *end == '\0' && errno == 0 && std::isfinite(parsed)) {
+            rules.*info.real = parsed;
+            return true;
+        }
+    } else {
+        long parsed = std::strtol(begin, &end, 10);
+        if (end != begin && *end == '\0' && errno == 0 && parsed >= INT32_MIN && parsed <= INT32_MAX) {
+            rules.*info.integer = static_cast<int32_t>(parsed);
+            return true;
+        }
+    }
+    error = std::string("invalid value '") + value + "' for " + info.name;
+    return false;
+}
+
+bool validate_rules(const Rules& rules, std::string& error) {
+    if (!(rules.max_energy > 0.0f)) {
+        error = "max_energy must be positive";
+    } else if (rules.move_cost < 0.0f || rules.attack_cost < 0.0f || rules.reproduce_cost < 0.0f) {
+        error = "costs cannot be negative";
+    } else if (rules.photosynthesis_base_rate < 0.0f) {
+        error = "photosynthesis_base_rate cannot be negative";
+    } else if (rules.density_mutation_factor < 0.0f || rules.density_mutation_factor * 8.0f > 1.0f) {
+        error = "density_mutation_factor must be in [0, 1/8]";
+    } else if (rules.fertility_delay < 0) {
+        error = "fertility_delay cannot be negative";
+    } else if (rules.initial_population < 0) {
+        error = "initial_population cannot be negative";
+    } else if (rules.hunt_range < 0 || rules.hunt_range > MAX_HUNT_RANGE) {
+        error = "hunt_range must be in [0, " + std::to_string(MAX_HUNT_RANGE) + "]";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+static std::string trim(const std::string& text) {
+    const char* space = " \t\r";
+    size_t first = text.find_first_not_of(space);
+    if (first == std::string::npos) return std::string();
+    return text.substr(first, text.find_last_not_of(space) - first + 1);
+}
+
+bool load_rules(const std::string& path, Rules& rules, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    Rules loaded = rules;
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        const std::string where = path + ":" + std::to_string(number) + ": ";
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = where + "expected name = value";
+            return false;
+        }
+        std::string name = trim(line.substr(0, equals));
+        const RuleInfo* info = find_rule(name);
+        if (!info) {
+            error = where + "unknown rule " + name;
+            return false;
+        }
+        if (!set_rule(loaded, *info, trim(line.substr(equals + 1)), error)) {
+            error = where + error;
+            return false;
+        }
+    }
+    if (!validate_rules(loaded, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    rules = loaded;
+    return true;
+}
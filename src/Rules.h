@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Costs and rates of the built-in rules, fixed for the life of a world.
+// Checkpoints carry them, so a loaded world keeps the rules it ran under.
+struct Rules {
+    float move_cost = 1.0f;
+    float attack_cost = 1.0f;
+    float reproduce_cost = 10.0f;
+    float photosynthesis_base_rate = 0.5f;
+    float max_energy = 100.0f;
+    float density_mutation_factor = 0.0000001f; // Chance of mutation per neighbor
+    int32_t fertility_delay = 100;              // Age before reproducing or mutating
+    int32_t initial_population = 50;            // Organisms placed at start and on restart
+    int32_t hunt_range = 0;                     // Cells carnivores sense prey across, 0: they wander blindly
+};
+
+// One rule by name, for config files, sweeps and CSV columns. Exactly one
+// of the members is set.
+struct RuleInfo {
+    const char* name;
+    float Rules::*real;
+    int32_t Rules::*integer;
+};
+
+extern const RuleInfo RULE_INFO[];
+extern const int RULE_COUNT;
+
+const RuleInfo* find_rule(const std::string& name);
+double get_rule(const Rules& rules, const RuleInfo& info);
+bool set_rule(Rules& rules, const RuleInfo& info, const std::string& value, std::string& error);
+// Checks the values make a world that can run
+bool validate_rules(const Rules& rules, std::string& error);
+
+// Reads `name = value` lines; blank lines and text after '#' are ignored.
+// Rules missing from the file keep the values already in `rules`.
+bool load_rules(const std::string& path, Rules& rules, std::string& error);
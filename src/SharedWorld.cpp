@@ -0,0 +1,333 @@
+#include "SharedWorld.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32_t SHARED_WORLD_MAGIC = 0x56455753; // "SWEV"
+constexpr size_t STATUS_CHARS = 128;
+
+// Everything in the objects is copied byte for byte between processes
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock-free");
+static_assert(std::atomic<size_t>::is_always_lock_free, "shared counters must be lock-free");
+static_assert(std::is_trivially_copyable<Command>::value, "commands cross processes as bytes");
+static_assert(std::is_trivially_copyable<Statistics>::value, "statistics cross processes as bytes");
+static_assert(std::is_trivially_copyable<SpeciesInfo>::value, "species cross processes as bytes");
+static_assert(std::is_trivially_copyable<TelemetryPoint>::value, "telemetry crosses processes as bytes");
+
+// The fixed-size fields of a Snapshot
+struct FrameInfo {
+    uint64_t number; // Frames published before this one, plus one
+    uint64_t version;
+    int32_t width, height;
+    uint32_t tick_count;
+    uint64_t seed;
+    uint8_t simulating, recording;
+    float ticks_per_second;
+    Statistics stats;
+    uint32_t species_count, species_appeared, species_extinct;
+    uint32_t top_species_count;
+    SpeciesInfo top_species[TOP_SPECIES];
+    uint32_t history_ticks;
+    uint32_t history_count;
+    ViewRect view;
+    uint32_t image_size; // Pixels, 0 when the view was too large to send
+    char checkpoint_status[STATUS_CHARS];
+};
+
+struct FrameSlot {
+    std::atomic<uint64_t> sequence; // Odd while being written
+    FrameInfo info;
+    TelemetryPoint history[SHARED_HISTORY_POINTS];
+    uint32_t image[SHARED_FRAME_MAX_PIXELS];
+};
+
+struct SharedFrames {
+    uint32_t magic, version;
+    uint64_t size;
+    std::atomic<uint64_t> published; // Newest frame is in slot (published - 1) % SHARED_FRAME_SLOTS
+    std::atomic<uint32_t> open;      // Process id of the simulation, 0 once it closed the world
+    FrameSlot slots[SHARED_FRAME_SLOTS];
+};
+
+struct SharedCommands {
+    uint32_t magic, version;
+    uint64_t size;
+    std::atomic<int32_t> viewer; // Process id of the attached viewer, 0: none
+    SpscQueue<Command, SHARED_COMMAND_SLOTS> queue;
+};
+
+#if !defined(_WIN32)
+static std::string object_path(const std::string& name, const char* suffix) {
+    return "/" + name + suffix;
+}
+
+// Maps a whole shared-memory object, creating it `size` bytes long if asked
+static void* map_object(const std::string& path, bool create, bool writable, size_t& size, std::string& error) {
+    int fd = create ? shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)
+                    : shm_open(path.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) {
+        error = (create ? "cannot create " : "cannot open ") + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat info;
+    if (create ? ftruncate(fd, static_cast<off_t>(size)) != 0 : fstat(fd, &info) != 0) {
+        error = "cannot size " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+    if (!create) size = static_cast<size_t>(info.st_size);
+    void* mapped = size ? mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+    return mapped;
+}
+#endif
+
+bool SharedWorldPublisher::create(const std::string& new_name, std::string& error) {
+    close();
+#if !defined(_WIN32)
+    if (new_name.empty() || new_name.find('/') != std::string::npos) {
+        error = "bad world name '" + new_name + "'";
+        return false;
+    }
+    const std::string frames_path = object_path(new_name, ""), commands_path = object_path(new_name, ".commands");
+    // Objects under the name are removed only when the simulation that
+    // shared them closed the world or is gone
+    size_t existing_size = 0;
+    std::string ignored;
+    if (void* existing = map_object(frames_path, false, false, existing_size, ignored)) {
+        const auto* previous = static_cast<const SharedFrames*>(existing);
+        const int32_t owner = existing_size >= sizeof(SharedFrames) && previous->magic == SHARED_WORLD_MAGIC
+                                  ? static_cast<int32_t>(previous->open.load(std::memory_order_acquire))
+                                  : 0;
+        munmap(existing, existing_size);
+        if (owner != 0 && (kill(owner, 0) == 0 || errno != ESRCH)) {
+            error = "world " + new_name + " is already shared";
+            return false;
+        }
+    }
+    shm_unlink(frames_path.c_str());
+    shm_unlink(commands_path.c_str());
+    size_t frames_size = sizeof(SharedFrames), commands_size = sizeof(SharedCommands);
+    void* frames_memory = map_object(frames_path, true, true, frames_size, error);
+    if (!frames_memory) return false;
+    void* commands_memory = map_object(commands_path, true, true, commands_size, error);
+    if (!commands_memory) {
+        munmap(frames_memory, frames_size);
+        shm_unlink(frames_path.c_str());
+        return false;
+    }
+    // New objects are zero-filled; only the headers and the queue need
+    // writing, the frame pages stay untouched until a frame lands in them
+    frames = new (frames_memory) SharedFrames;
+    frames->magic = SHARED_WORLD_MAGIC;
+    frames->version = SHARED_WORLD_VERSION;
+    frames->size = sizeof(SharedFrames);
+    frames->open.store(static_cast<uint32_t>(getpid()), std::memory_order_release);
+    commands = new (commands_memory) SharedCommands;
+    commands->magic = SHARED_WORLD_MAGIC;
+    commands->version = SHARED_WORLD_VERSION;
+    commands->size = sizeof(SharedCommands);
+    name = new_name;
+    return true;
+#else
+    error = "sharing a world needs POSIX shared memory";
+    return false;
+#endif
+}
+
+void SharedWorldPublisher::close() {
+    if (!frames) return;
+#if !defined(_WIN32)
+    frames->open.store(0, std::memory_order_release);
+    munmap(frames, sizeof(SharedFrames));
+    munmap(commands, sizeof(SharedCommands));
+    // An attached viewer keeps its mappings until it detaches
+    shm_unlink(object_path(name, "").c_str());
+    shm_unlink(object_path(name, ".commands").c_str());
+#endif
+    frames = nullptr;
+    commands = nullptr;
+}
+
+void SharedWorldPublisher::publish(const Snapshot& snapshot) {
+    if (!frames) return;
+    const uint64_t number = frames->published.load(std::memory_order_relaxed);
+    FrameSlot& slot = frames->slots[number % SHARED_FRAME_SLOTS];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    FrameInfo& info = slot.info;
+    info.number = number + 1;
+    info.version = snapshot.version;
+    info.width = snapshot.width;
+    info.height = snapshot.height;
+    info.tick_count = snapshot.tick_count;
+    info.seed = snapshot.seed;
+    info.simulating = snapshot.simulating;
+    info.recording = snapshot.recording;
+    info.ticks_per_second = snapshot.ticks_per_second;
+    info.stats = snapshot.stats;
+    info.species_count = snapshot.species_count;
+    info.species_appeared = snapshot.species_appeared;
+    info.species_extinct = snapshot.species_extinct;
+    info.top_species_count = static_cast<uint32_t>(std::min<size_t>(snapshot.top_species.size(), TOP_SPECIES));
+    std::copy_n(snapshot.top_species.begin(), info.top_species_count, info.top_species);
+    info.history_ticks = snapshot.history_ticks;
+    // The newest points, should the history ever be longer than a frame holds
+    info.history_count = static_cast<uint32_t>(std::min<size_t>(snapshot.history.size(), SHARED_HISTORY_POINTS));
+    std::copy(snapshot.history.end() - info.history_count, snapshot.history.end(), slot.history);
+    const size_t pixels = static_cast<size_t>(snapshot.view.width) * snapshot.view.height;
+    if (pixels <= SHARED_FRAME_MAX_PIXELS && snapshot.image.size() == pixels) {
+        info.view = snapshot.view;
+        info.image_size = static_cast<uint32_t>(pixels);
+        std::memcpy(slot.image, snapshot.image.data(), pixels * sizeof(uint32_t));
+    } else {
+        info.view = ViewRect();
+        info.image_size = 0;
+    }
+    const size_t status = std::min(snapshot.checkpoint_status.size(), STATUS_CHARS - 1);
+    std::memcpy(info.checkpoint_status, snapshot.checkpoint_status.data(), status);
+    info.checkpoint_status[status] = '\0';
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    frames->published.store(number + 1, std::memory_order_release);
+}
+
+bool SharedWorldPublisher::pop(Command& command) {
+    return commands && commands->queue.pop(command);
+}
+
+bool SharedWorldViewer::attach(const std::string& new_name, std::string& error) {
+    detach();
+#if !defined(_WIN32)
+    const std::string frames_path = object_path(new_name, ""), commands_path = object_path(new_name, ".commands");
+    size_t size = 0, commands_size = 0;
+    void* frames_memory = map_object(frames_path, false, false, size, error);
+    if (!frames_memory) return false;
+    void* commands_memory = map_object(commands_path, false, true, commands_size, error);
+    if (!commands_memory) {
+        munmap(frames_memory, size);
+        return false;
+    }
+    frames = static_cast<const SharedFrames*>(frames_memory);
+    commands = static_cast<SharedCommands*>(commands_memory);
+    frames_size = size;
+    if (size < sizeof(SharedFrames) || commands_size != sizeof(SharedCommands) || frames->magic != SHARED_WORLD_MAGIC ||
+        frames->version != SHARED_WORLD_VERSION || frames->size != sizeof(SharedFrames) ||
+        commands->magic != SHARED_WORLD_MAGIC || commands->size != sizeof(SharedCommands)) {
+        error = "'" + new_name + "' was shared by a different build";
+        munmap(commands_memory, commands_size);
+        commands = nullptr;
+        detach();
+        return false;
+    }
+
+    // The command queue has one producer: take it over only from a viewer
+    // that is gone
+    const int32_t self = static_cast<int32_t>(getpid());
+    int32_t owner = 0;
+    while (!commands->viewer.compare_exchange_strong(owner, self)) {
+        if (kill(owner, 0) == 0 || errno != ESRCH) {
+            error = "another viewer (process " + std::to_string(owner) + ") is attached";
+            munmap(commands_memory, commands_size);
+            commands = nullptr;
+            detach();
+            return false;
+        }
+    }
+    name = new_name;
+    frame_number = 0;
+    snapshot = Snapshot();
+    latest();
+    return true;
+#else
+    error = "attaching to a world needs POSIX shared memory";
+    return false;
+#endif
+}
+
+void SharedWorldViewer::detach() {
+#if !defined(_WIN32)
+    if (commands) {
+        // Nobody is looking any more: stop the simulation drawing the view
+        post(Command{Command::Type::SetView});
+        int32_t self = static_cast<int32_t>(getpid());
+        commands->viewer.compare_exchange_strong(self, 0);
+        munmap(commands, sizeof(SharedCommands));
+    }
+    if (frames) munmap(const_cast<SharedFrames*>(frames), frames_size);
+#endif
+    frames = nullptr;
+    commands = nullptr;
+}
+
+bool SharedWorldViewer::is_connected() const {
+    return frames && frames->open.load(std::memory_order_acquire);
+}
+
+bool SharedWorldViewer::post(const Command& command) {
+    return commands && commands->queue.push(command);
+}
+
+bool SharedWorldViewer::read_frame(uint64_t number) {
+    // Seqlock read: copy, then keep the copy only if the slot's sequence was
+    // even and unchanged throughout. A torn copy is simply thrown away.
+    const FrameSlot& slot = frames->slots[(number - 1) % SHARED_FRAME_SLOTS];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) return false;
+    FrameInfo info;
+    std::memcpy(&info, &slot.info, sizeof(FrameInfo));
+    const size_t history = std::min<size_t>(info.history_count, SHARED_HISTORY_POINTS);
+    const size_t pixels = std::min<size_t>(info.image_size, SHARED_FRAME_MAX_PIXELS);
+    incoming.history.assign(slot.history, slot.history + history);
+    incoming.image.assign(slot.image, slot.image + pixels);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) return false;
+
+    incoming.version = info.version;
+    incoming.width = info.width;
+    incoming.height = info.height;
+    incoming.tick_count = info.tick_count;
+    incoming.seed = info.seed;
+    incoming.simulating = info.simulating != 0;
+    incoming.recording = info.recording != 0;
+    incoming.ticks_per_second = info.ticks_per_second;
+    incoming.stats = info.stats;
+    incoming.species_count = info.species_count;
+    incoming.species_appeared = info.species_appeared;
+    incoming.species_extinct = info.species_extinct;
+    incoming.top_species.assign(info.top_species, info.top_species + std::min<uint32_t>(info.top_species_count, TOP_SPECIES));
+    incoming.history_ticks = info.history_ticks;
+    incoming.view = static_cast<size_t>(info.view.width) * info.view.height == pixels ? info.view : ViewRect();
+    info.checkpoint_status[STATUS_CHARS - 1] = '\0';
+    incoming.checkpoint_status = info.checkpoint_status;
+    std::swap(snapshot, incoming);
+    frame_number = info.number;
+    return true;
+}
+
+const Snapshot& SharedWorldViewer::latest() {
+    if (!frames) return snapshot;
+    // The writer can lap a slow reader; after a few tries keep the old frame
+    uint64_t published = frames->published.load(std::memory_order_acquire);
+    for (int attempt = 0; attempt < 4 && published && published != frame_number; ++attempt) {
+        if (read_frame(published)) break;
+        published = frames->published.load(std::memory_order_acquire);
+    }
+    return snapshot;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Simulation.h"
+
+// A Simulation shared with a viewer in another process through two POSIX
+// shared-memory objects named after the world:
+//   /NAME          a ring of SHARED_FRAME_SLOTS frames, written only by the
+//                  simulation and mapped read-only by the viewer
+//   /NAME.commands a SpscQueue of Commands from the viewer to the simulation
+// A frame is a Snapshot flattened to fixed-size arrays. Each slot carries a
+// seqlock sequence, odd while the slot is being written: the reader copies
+// the newest slot and keeps the copy only if the sequence did not move. The
+// writer never waits and publishing is plain stores, no system calls.
+// One viewer is attached at a time; it can come and go while the world runs.
+constexpr int SHARED_FRAME_SLOTS = 3;
+constexpr int SHARED_FRAME_MAX_PIXELS = 1 << 20; // Larger views are sent without an image
+constexpr int SHARED_HISTORY_POINTS = 1024;      // Newest telemetry points in a frame
+constexpr size_t SHARED_COMMAND_SLOTS = 256;
+constexpr uint32_t SHARED_WORLD_VERSION = 1;     // Bumped whenever the layout changes
+
+struct SharedFrames;
+struct SharedCommands;
+
+// Simulation side: creates both objects and removes them again on close()
+class SharedWorldPublisher {
+private:
+    std::string name;
+    SharedFrames* frames = nullptr;
+    SharedCommands* commands = nullptr;
+
+public:
+    SharedWorldPublisher() = default;
+    SharedWorldPublisher(const SharedWorldPublisher&) = delete;
+    SharedWorldPublisher& operator=(const SharedWorldPublisher&) = delete;
+    ~SharedWorldPublisher() { close(); }
+
+    // Fails while another live process shares a world under `name`;
+    // objects left behind by one that died are replaced
+    bool create(const std::string& name, std::string& error);
+    void close();
+    bool is_open() const { return frames != nullptr; }
+    void publish(const Snapshot& snapshot);
+    bool pop(Command& command);
+};
+
+// Viewer side. latest() mirrors Simulation::latest(): the newest complete
+// frame as a Snapshot, or the previous one while no newer frame has come.
+class SharedWorldViewer {
+private:
+    std::string name;
+    const SharedFrames* frames = nullptr;
+    SharedCommands* commands = nullptr;
+    size_t frames_size = 0;
+    uint64_t frame_number = 0; // Of `snapshot`
+    Snapshot snapshot;
+    Snapshot incoming; // Copy being read, kept only if the slot did not change under it
+
+    bool read_frame(uint64_t number);
+
+public:
+    SharedWorldViewer() = default;
+    SharedWorldViewer(const SharedWorldViewer&) = delete;
+    SharedWorldViewer& operator=(const SharedWorldViewer&) = delete;
+    ~SharedWorldViewer() { detach(); }
+
+    bool attach(const std::string& name, std::string& error);
+    void detach();
+    // False once the simulation process has closed the world
+    bool is_connected() const;
+    bool post(const Command& command);
+    const Snapshot& latest();
+};
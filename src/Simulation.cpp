@@ -0,0 +1,230 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include "Profiler.h"
+#include "SharedWorld.h"
+
+using Clock = std::chrono::steady_clock;
+
+// The UI draws at display rate; publishing much faster only burns copies
+constexpr auto PUBLISH_INTERVAL = std::chrono::microseconds(1000000 / 120);
+
+Simulation::Simulation(const FieldSettings& settings, int tps_limit) : field(settings), tps_limit(tps_limit) {
+    publish(); // The UI always has something to show
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+}
+
+void Simulation::run() {
+    PROFILE_THREAD("simulation");
+    auto next_tick = Clock::now();
+    auto next_publish = next_tick;
+    auto window_start = next_tick;
+    uint32_t window_ticks = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        Command command;
+        bool changed = false;
+        while (commands.pop(command)) {
+            apply(command);
+            changed = true;
+        }
+        while (shared && shared->pop(command)) {
+            apply(command);
+            changed = true;
+        }
+
+        auto now = Clock::now();
+        bool ticked = false;
+        if (field.is_simulating() && (tps_limit <= 0 || now >= next_tick)) {
+            field.tick();
+            record(std::chrono::duration<float, std::micro>(Clock::now() - now).count());
+            if (recorder.is_recording()) recorder.append(field.get_tick_count(), field);
+            ticked = true;
+            if (checkpoint_every && field.get_tick_count() % checkpoint_every == 0) {
+                save_checkpoint();
+            }
+            ++window_ticks;
+            if (tps_limit > 0) {
+                // Catch up at most one tick behind instead of bursting
+                next_tick = std::max(next_tick + std::chrono::microseconds(1000000 / tps_limit), now);
+            }
+        }
+
+        if (now - window_start >= std::chrono::milliseconds(500)) {
+            measured_tps = window_ticks / std::chrono::duration<float>(now - window_start).count();
+            window_start = now;
+            window_ticks = 0;
+        }
+
+        if (changed || now >= next_publish) {
+            publish();
+            next_publish = now + PUBLISH_INTERVAL;
+        }
+
+        if (!ticked) {
+            // Paused or ahead of the TPS limit: nap until there is work
+            auto wake = field.is_simulating() && tps_limit > 0 ? std::min(next_tick, next_publish) : next_publish;
+            std::this_thread::sleep_until(std::min(wake, Clock::now() + std::chrono::milliseconds(2)));
+        }
+    }
+}
+
+void Simulation::apply(const Command& command) {
+    switch (command.type) {
+        case Command::Type::TogglePause:
+            field.toggle_simulation();
+            break;
+        case Command::Type::Restart:
+            stop_recording(); // A log covers one continuous run
+            field.restart(command.seed);
+            telemetry.clear();
+            break;
+        case Command::Type::Spawn:
+            field.add_organism(command.x, command.y, command.organism_type);
+            break;
+        case Command::Type::SetTps:
+            tps_limit = command.tps;
+            break;
+        case Command::Type::SetHistory:
+            history_ticks = command.history_ticks;
+            break;
+        case Command::Type::SetView:
+            view = command.view;
+            break;
+        case Command::Type::SaveCheckpoint:
+            save_checkpoint();
+            break;
+        case Command::Type::LoadCheckpoint:
+            stop_recording();
+            load_checkpoint();
+            break;
+        case Command::Type::StartRecording:
+            start_recording();
+            break;
+        case Command::Type::StopRecording:
+            stop_recording();
+            break;
+    }
+}
+
+void Simulation::set_checkpoint(const std::string& path, uint32_t every_ticks) {
+    checkpoint_path = path;
+    checkpoint_every = every_ticks;
+}
+
+bool Simulation::load(const std::string& path, std::string& error) {
+    if (!::load_checkpoint(field, path, error)) return false;
+    publish();
+    return true;
+}
+
+bool Simulation::share(const std::string& name, std::string& error) {
+    shared = std::make_unique<SharedWorldPublisher>();
+    if (!shared->create(name, error)) {
+        shared.reset();
+        return false;
+    }
+    publish(); // A viewer attaching before the first tick has a frame
+    return true;
+}
+
+void Simulation::save_checkpoint() {
+    if (checkpoint_path.empty()) return;
+    // Encoding is a copy of the arrays; the disk write happens on the writer's thread
+    field.save_checkpoint(checkpoint_image);
+    writer.submit(checkpoint_path, checkpoint_image);
+    checkpoint_status = "Checkpoint at tick " + std::to_string(field.get_tick_count());
+}
+
+void Simulation::load_checkpoint() {
+    if (checkpoint_path.empty()) return;
+    writer.wait(); // The file may still be on its way to disk
+    std::string error;
+    if (::load_checkpoint(field, checkpoint_path, error)) {
+        telemetry.clear();
+        checkpoint_status = "Loaded tick " + std::to_string(field.get_tick_count());
+    } else {
+        checkpoint_status = "Load failed: " + error;
+    }
+}
+
+void Simulation::start_recording() {
+    if (event_log_path.empty() || recorder.is_recording()) return;
+    std::string error;
+    if (recorder.start(event_log_path, field, error)) {
+        field.set_recording(true);
+        checkpoint_status = "Recording from tick " + std::to_string(field.get_tick_count());
+    } else {
+        checkpoint_status = "Recording failed: " + error;
+    }
+}
+
+void Simulation::stop_recording() {
+    if (!recorder.is_recording()) return;
+    field.set_recording(false);
+    recorder.stop();
+    std::string error = recorder.get_last_error();
+    checkpoint_status = error.empty() ? "Recorded up to tick " + std::to_string(field.get_tick_count())
+                                      : "Recording failed: " + error;
+}
+
+void Simulation::record(float tick_micros) {
+    const Statistics& stats = field.get_statistics();
+    float values[METRIC_COUNT];
+    values[static_cast<int>(Metric::Photosynthetic)] = static_cast<float>(stats.get_count(OrganismType::Photosynthetic));
+    values[static_cast<int>(Metric::Carnivorous)] = static_cast<float>(stats.get_count(OrganismType::Carnivorous));
+    values[static_cast<int>(Metric::MeanEnergy)] = stats.get_mean_energy();
+    values[static_cast<int>(Metric::Births)] = static_cast<float>(stats.get_births());
+    values[static_cast<int>(Metric::Deaths)] = static_cast<float>(stats.get_deaths());
+    values[static_cast<int>(Metric::TickMicros)] = tick_micros;
+    telemetry.record(field.get_tick_count(), values);
+}
+
+void Simulation::publish() {
+    ++version;
+    field.update_detail(version);
+
+    // The back buffer last held an older version of the view; repaint what
+    // changed since, or all of it for a different view
+    Snapshot& snapshot = snapshots.write_buffer();
+    uint64_t since = snapshot.version;
+    if (snapshot.view != view || snapshot.width != field.get_width() || snapshot.height != field.get_height()) {
+        snapshot.view = view;
+        snapshot.image.resize(static_cast<size_t>(view.width) * view.height);
+        since = 0;
+    }
+    field.draw(view, snapshot.image.data(), since);
+    snapshot.version = version;
+    snapshot.width = field.get_width();
+    snapshot.height = field.get_height();
+    snapshot.tick_count = field.get_tick_count();
+    snapshot.seed = field.get_seed();
+    snapshot.simulating = field.is_simulating();
+    snapshot.ticks_per_second = measured_tps;
+    snapshot.stats = field.get_statistics();
+    const SpeciesIndex& species = field.get_species();
+    snapshot.species_count = species.get_species_count();
+    snapshot.species_appeared = species.get_appeared();
+    snapshot.species_extinct = species.get_extinct();
+    species.get_top(TOP_SPECIES, snapshot.top_species);
+    snapshot.history_ticks = history_ticks;
+    std::string write_error = writer.get_last_error();
+    snapshot.recording = recorder.is_recording();
+    snapshot.checkpoint_status = write_error.empty() ? checkpoint_status : "Save failed: " + write_error;
+    telemetry.query(history_ticks, snapshot.history);
+    if (shared) shared->publish(snapshot);
+    snapshots.publish();
+}
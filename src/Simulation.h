@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Checkpoint.h"
+#include "EventLog.h"
+#include "Field.h"
+#include "SpscQueue.h"
+#include "Telemetry.h"
+#include "TripleBuffer.h"
+
+constexpr int TOP_SPECIES = 5; // Species listed in a Snapshot
+
+// Read-only picture of the world handed from the simulation thread to the UI
+struct Snapshot {
+    uint64_t version = 0;
+    int width = 0, height = 0;
+    uint32_t tick_count = 0;
+    uint64_t seed = 0;
+    bool simulating = true;
+    float ticks_per_second = 0.0f;
+    Statistics stats;
+    uint32_t species_count = 0;
+    uint32_t species_appeared = 0, species_extinct = 0; // During the last tick
+    std::vector<SpeciesInfo> top_species;                // Most populous first
+    uint32_t history_ticks = 0;           // Span asked for with SetHistory, 0: all
+    std::vector<TelemetryPoint> history;  // Oldest first
+    std::string checkpoint_status;        // Outcome of the last checkpoint action
+    bool recording = false;               // Events are going to the event log
+    ViewRect view;               // Part of the world `image` shows, as asked with SetView
+    std::vector<uint32_t> image; // ARGB8888, view.width x view.height, white where empty
+};
+
+// Control actions from the UI, applied by the simulation thread between ticks
+struct Command {
+    enum class Type { TogglePause, Restart, Spawn, SetTps, SetHistory, SetView, SaveCheckpoint, LoadCheckpoint, StartRecording, StopRecording };
+    Type type;
+    int x = 0, y = 0;
+    OrganismType organism_type = OrganismType::Photosynthetic;
+    uint64_t seed = 0;
+    int tps = 0; // 0: unlimited
+    uint32_t history_ticks = 0; // 0: the whole run
+    ViewRect view;
+};
+
+class SharedWorldPublisher;
+
+// Runs a Field on its own thread. The UI never touches the Field: it reads
+// the latest Snapshot and sends Commands. A shared Simulation also hands
+// every Snapshot to a viewer in another process, see SharedWorld.h.
+class Simulation {
+private:
+    Field field;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    SpscQueue<Command, 256> commands;
+    TripleBuffer<Snapshot> snapshots;
+
+    // Simulation thread state
+    int tps_limit;
+    uint64_t version = 0;
+    ViewRect view; // Pictured in every Snapshot
+    float measured_tps = 0.0f;
+    Telemetry telemetry;
+    uint32_t history_ticks = 10000;
+    std::string checkpoint_path;
+    uint32_t checkpoint_every = 0;         // Ticks between automatic saves, 0: never
+    std::vector<uint8_t> checkpoint_image; // Encoded here, written by `writer`
+    CheckpointWriter writer;
+    std::string checkpoint_status;
+    std::string event_log_path;
+    EventRecorder recorder;
+    std::unique_ptr<SharedWorldPublisher> shared;
+
+    void run();
+    void apply(const Command& command);
+    void publish();
+    void record(float tick_micros);
+    void save_checkpoint();
+    void load_checkpoint();
+    void start_recording();
+    void stop_recording();
+
+public:
+    Simulation(const FieldSettings& settings, int tps_limit = 60);
+    ~Simulation();
+
+    // Where SaveCheckpoint and LoadCheckpoint go, and how often to save on
+    // the side while running. Call before start().
+    void set_checkpoint(const std::string& path, uint32_t every_ticks);
+    // Where StartRecording writes the event log. Call before start().
+    void set_event_log(const std::string& path) { event_log_path = path; }
+    // Replaces the world with a checkpoint. Call before start().
+    bool load(const std::string& path, std::string& error);
+    // Publishes frames to, and takes Commands from, a viewer process
+    // attached under `name`. Call before start().
+    bool share(const std::string& name, std::string& error);
+    void start();
+    void stop();
+
+    // UI thread
+    bool post(const Command& command) { return commands.push(command); }
+    const Snapshot& latest() { snapshots.update(); return snapshots.read_buffer(); }
+};
@@ -0,0 +1,93 @@
+#include "Species.h"
+#include <algorithm>
+#include "Random.h"
+
+SpeciesKey species_key(const Markers& founder) {
+    uint64_t key = 0;
+    for (int marker : founder) {
+        key = hash_combine(key, static_cast<uint32_t>(marker));
+    }
+    return key;
+}
+
+int count_shared_markers(const Markers& a, const Markers& b) {
+    int shared = 0;
+    for (int i = 0; i < MUTATION_MARKERS_COUNT; ++i) {
+        if (a[i] == b[i]) ++shared;
+    }
+    return shared;
+}
+
+void SpeciesIndex::clear() {
+    species.clear();
+    lookup.clear();
+    appeared = extinct = 0;
+    total_appeared = 0;
+}
+
+void SpeciesIndex::add(SpeciesKey key, const Markers& markers, uint32_t tick) {
+    auto found = lookup.find(key);
+    if (found != lookup.end()) {
+        SpeciesInfo& info = species[found->second];
+        ++info.population;
+        info.peak = std::max(info.peak, info.population);
+        return;
+    }
+    lookup.emplace(key, static_cast<uint32_t>(species.size()));
+    species.push_back({key, markers, 1, tick, 1});
+    ++appeared;
+    ++total_appeared;
+}
+
+void SpeciesIndex::remove(SpeciesKey key) {
+    auto found = lookup.find(key);
+    if (found == lookup.end()) return;
+    uint32_t index = found->second;
+    if (--species[index].population > 0) return;
+    // Extinct: move the last species into the gap
+    lookup.erase(found);
+    if (index + 1 != species.size()) {
+        species[index] = species.back();
+        lookup[species[index].key] = index;
+    }
+    species.pop_back();
+    ++extinct;
+}
+
+void SpeciesIndex::apply(std::vector<SpeciesDelta>& deltas, uint32_t tick) {
+    for (const SpeciesDelta& delta : deltas) {
+        if (delta.change > 0) {
+            add(delta.key, delta.markers, tick);
+        } else {
+            remove(delta.key);
+        }
+    }
+    deltas.clear();
+}
+
+void SpeciesIndex::insert(const Markers& founder, uint32_t birth_tick) {
+    SpeciesKey key = species_key(founder);
+    add(key, founder, birth_tick);
+    SpeciesInfo& info = species[lookup[key]];
+    info.origin_tick = std::min(info.origin_tick, birth_tick);
+}
+
+uint32_t SpeciesIndex::get_population(SpeciesKey key) const {
+    const SpeciesInfo* info = find(key);
+    return info ? info->population : 0;
+}
+
+const SpeciesInfo* SpeciesIndex::find(SpeciesKey key) const {
+    auto found = lookup.find(key);
+    return found == lookup.end() ? nullptr : &species[found->second];
+}
+
+void SpeciesIndex::get_top(size_t count, std::vector<SpeciesInfo>& out) const {
+    out.resize(std::min(count, species.size()));
+    std::partial_sort_copy(species.begin(), species.end(), out.begin(), out.end(),
+                           [](const SpeciesInfo& a, const SpeciesInfo& b) {
+        if (a.population != b.population) return a.population > b.population;
+        if (a.origin_tick != b.origin_tick) return a.origin_tick < b.origin_tick;
+        return a.key < b.key;
+    });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Types.h"
+
+using Markers = std::array<int, MUTATION_MARKERS_COUNT>;
+
+// Every birth rewrites one marker, so a species is a lineage rather than a
+// set of identical markers: a child belongs to its parent's species while
+// it shares at least SPECIES_KINSHIP markers with the species' founder, and
+// founds a new species otherwise. The key is a hash of the founder's
+// markers, so it is known the moment an organism is born and needs no
+// shared state to compute.
+constexpr int SPECIES_KINSHIP = 2;
+
+using SpeciesKey = uint64_t;
+SpeciesKey species_key(const Markers& founder);
+int count_shared_markers(const Markers& a, const Markers& b);
+
+// One organism joining (+1) or leaving (-1) a species, recorded in a tile's
+// ChangeLog and applied when the logs are merged
+struct SpeciesDelta {
+    SpeciesKey key;
+    Markers markers; // The founder's
+    int32_t change;
+};
+
+struct SpeciesInfo {
+    SpeciesKey key;
+    Markers markers; // The founder's
+    uint32_t population;
+    uint32_t origin_tick; // When it (re)appeared; for a loaded world, its oldest member's birth
+    uint32_t peak;        // Largest population so far
+};
+
+// Living species and their populations, kept up to date from the births
+// and deaths of every tick. Queries scan species, never organisms.
+class SpeciesIndex {
+private:
+    std::vector<SpeciesInfo> species;                 // Living species, unordered
+    std::unordered_map<SpeciesKey, uint32_t> lookup;  // Key -> index in `species`
+    uint32_t appeared = 0, extinct = 0;                // During the last tick
+    uint64_t total_appeared = 0;                      // Since the start or the last load
+
+    void add(SpeciesKey key, const Markers& markers, uint32_t tick);
+    void remove(SpeciesKey key);
+
+public:
+    void clear();
+    void begin_tick() { appeared = extinct = 0; }
+    void apply(std::vector<SpeciesDelta>& deltas, uint32_t tick); // Also clears the deltas
+    // Counts an organism of a loaded world
+    void insert(const Markers& founder, uint32_t birth_tick);
+
+    uint32_t get_species_count() const { return static_cast<uint32_t>(species.size()); }
+    uint32_t get_population(SpeciesKey key) const;
+    const SpeciesInfo* find(SpeciesKey key) const;
+    // The `count` most populous species, largest first; ties go to the
+    // older species, then the smaller key
+    void get_top(size_t count, std::vector<SpeciesInfo>& out) const;
+    uint32_t get_appeared() const { return appeared; }
+    uint32_t get_extinct() const { return extinct; }
+    uint64_t get_total_appeared() const { return total_appeared; }
+};
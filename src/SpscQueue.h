@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread
+template <typename T, size_t Capacity>
+class SpscQueue {
+private:
+    std::array<T, Capacity> items;
+    std::atomic<size_t> head{0}; // Next slot to pop, advanced by the consumer
+    std::atomic<size_t> tail{0}; // Next slot to push, advanced by the producer
+
+public:
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[t % Capacity] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h % Capacity];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
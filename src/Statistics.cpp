@@ -0,0 +1,86 @@
+#include "Statistics.h"
+
+void StatsDelta::add(OrganismType type, float energy, uint32_t birth_tick) {
+    ++count[static_cast<int>(type)];
+    this->energy += energy;
+    ++age_buckets[(birth_tick / AGE_BUCKET_TICKS) % AGE_BUCKETS];
+}
+
+void StatsDelta::remove(OrganismType type, float energy, uint32_t birth_tick, uint32_t oldest_window) {
+    --count[static_cast<int>(type)];
+    this->energy -= energy;
+    ++deaths;
+    uint32_t window = birth_tick / AGE_BUCKET_TICKS;
+    if (window < oldest_window) {
+        --older;
+    } else {
+        --age_buckets[window % AGE_BUCKETS];
+    }
+}
+
+void StatsDelta::change_type(OrganismType from, OrganismType to) {
+    --count[static_cast<int>(from)];
+    ++count[static_cast<int>(to)];
+}
+
+void Statistics::reset(uint32_t tick) {
+    *this = Statistics();
+    current_window = tick / AGE_BUCKET_TICKS;
+}
+
+void Statistics::begin_tick(uint32_t tick) {
+    births = deaths = kills = updates = 0;
+    // Roll the age windows: the oldest bucket joins `older` and is reused
+    uint32_t window = tick / AGE_BUCKET_TICKS;
+    while (current_window < window) {
+        ++current_window;
+        int32_t& bucket = age_buckets[current_window % AGE_BUCKETS];
+        older += bucket;
+        bucket = 0;
+    }
+}
+
+void Statistics::apply(StatsDelta& delta) {
+    for (int i = 0; i < ORGANISM_TYPE_COUNT; ++i) {
+        count[i] += delta.count[i];
+    }
+    energy += delta.energy;
+    births += delta.births;
+    deaths += delta.deaths;
+    kills += delta.kills;
+    total_births += delta.births;
+    total_deaths += delta.deaths;
+    total_kills += delta.kills;
+    updates += delta.updates;
+    total_updates += delta.updates;
+    for (int i = 0; i < AGE_BUCKETS; ++i) {
+        age_buckets[i] += delta.age_buckets[i];
+    }
+    older += delta.older;
+    delta = StatsDelta();
+}
+
+void Statistics::insert(OrganismType type, float energy, uint32_t birth_tick) {
+    ++count[static_cast<int>(type)];
+    this->energy += energy;
+    uint32_t window = birth_tick / AGE_BUCKET_TICKS;
+    if (window < get_oldest_window()) {
+        ++older;
+    } else {
+        ++age_buckets[window % AGE_BUCKETS];
+    }
+}
+
+void Statistics::set_totals(uint64_t births, uint64_t deaths, uint64_t kills) {
+    total_births = births;
+    total_deaths = deaths;
+    total_kills = kills;
+}
+
+void Statistics::get_age_histogram(uint32_t out[AGE_BUCKETS + 1]) const {
+    for (int i = 0; i < AGE_BUCKETS; ++i) {
+        uint32_t window = current_window - i;
+        out[i] = i <= static_cast<int>(current_window) ? static_cast<uint32_t>(age_buckets[window % AGE_BUCKETS]) : 0;
+    }
+    out[AGE_BUCKETS] = static_cast<uint32_t>(older);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include "Types.h"
+
+constexpr int ORGANISM_TYPE_COUNT = 2;
+constexpr int AGE_BUCKETS = 32;         // Plus one for everything older
+constexpr int AGE_BUCKET_TICKS = 256;
+
+// Changes gathered by one tile during a tick, or by one action outside it.
+// Age is tracked by birth tick: an organism's age is tick - birth_tick, so
+// the age histogram only moves when the bucket boundaries roll over.
+struct StatsDelta {
+    int32_t count[ORGANISM_TYPE_COUNT] = {};
+    double energy = 0.0;
+    uint32_t births = 0, deaths = 0, kills = 0;
+    uint32_t updates = 0; // Organism::update calls
+    int32_t age_buckets[AGE_BUCKETS] = {}; // Indexed by birth window % AGE_BUCKETS
+    int32_t older = 0;
+
+    void add(OrganismType type, float energy, uint32_t birth_tick);
+    void remove(OrganismType type, float energy, uint32_t birth_tick, uint32_t oldest_window);
+    void change_type(OrganismType from, OrganismType to);
+};
+
+// Population statistics kept up to date from StatsDelta merges, so every
+// query is O(1) in the size of the world.
+class Statistics {
+private:
+    uint32_t count[ORGANISM_TYPE_COUNT] = {};
+    double energy = 0.0;
+    uint32_t births = 0, deaths = 0, kills = 0; // During the last tick
+    uint64_t total_births = 0, total_deaths = 0, total_kills = 0;
+    uint32_t updates = 0;       // Organisms that acted during the last tick
+    uint64_t total_updates = 0; // Since the start or the last load
+    int32_t age_buckets[AGE_BUCKETS] = {};
+    int32_t older = 0;
+    uint32_t current_window = 0; // Birth window of organisms born this tick
+
+public:
+    void reset(uint32_t tick);
+    void begin_tick(uint32_t tick);
+    void apply(StatsDelta& delta); // Also clears the delta
+    // Counts an organism born at any earlier tick, for rebuilding the
+    // statistics of a loaded world
+    void insert(OrganismType type, float energy, uint32_t birth_tick);
+    void set_totals(uint64_t births, uint64_t deaths, uint64_t kills);
+
+    uint32_t get_count(OrganismType type) const { return count[static_cast<int>(type)]; }
+    uint32_t get_population() const { return count[0] + count[1]; }
+    double get_total_energy() const { return energy; }
+    float get_mean_energy() const { return get_population() ? static_cast<float>(energy / get_population()) : 0.0f; }
+    uint32_t get_births() const { return births; }
+    uint32_t get_deaths() const { return deaths; }
+    uint32_t get_kills() const { return kills; }
+    uint32_t get_updates() const { return updates; }
+    uint64_t get_total_updates() const { return total_updates; }
+    uint64_t get_total_births() const { return total_births; }
+    uint64_t get_total_deaths() const { return total_deaths; }
+    uint64_t get_total_kills() const { return total_kills; }
+    uint32_t get_oldest_window() const { return current_window < AGE_BUCKETS ? 0 : current_window - AGE_BUCKETS + 1; }
+    // Organisms per age bucket: bucket i holds ages of about
+    // [i, i + 1) * AGE_BUCKET_TICKS, bucket AGE_BUCKETS everything older
+    void get_age_histogram(uint32_t out[AGE_BUCKETS + 1]) const;
+};
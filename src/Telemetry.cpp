@@ -0,0 +1,87 @@
+#include "Telemetry.h"
+#include <algorithm>
+
+Telemetry::Telemetry(size_t capacity, int factor, int level_count)
+    : levels(std::max(1, level_count)), capacity(std::max<size_t>(1, capacity)), factor(std::max(2, factor)) {
+    for (Level& level : levels) {
+        level.points.resize(this->capacity);
+    }
+}
+
+void Telemetry::record(uint32_t tick, const float values[METRIC_COUNT]) {
+    TelemetryPoint point;
+    point.tick = tick;
+    point.ticks = 1;
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        point.min[i] = point.max[i] = point.mean[i] = values[i];
+    }
+    push(0, point);
+}
+
+void Telemetry::push(size_t index, const TelemetryPoint& point) {
+    Level& level = levels[index];
+    level.points[level.head] = point;
+    level.head = (level.head + 1) % capacity;
+    level.size = std::min(level.size + 1, capacity);
+    ++level.pushed;
+
+    if (index + 1 == levels.size()) return;
+    if (level.pending_count == 0) {
+        level.pending = point;
+    } else {
+        merge(level.pending, point);
+    }
+    if (++level.pending_count == factor) {
+        level.pending_count = 0;
+        push(index + 1, level.pending);
+    }
+}
+
+void Telemetry::merge(TelemetryPoint& into, const TelemetryPoint& point) {
+    // Means are weighted by the ticks each side covers
+    float total = static_cast<float>(into.ticks + point.ticks);
+    float a = into.ticks / total, b = point.ticks / total;
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        into.min[i] = std::min(into.min[i], point.min[i]);
+        into.max[i] = std::max(into.max[i], point.max[i]);
+        into.mean[i] = into.mean[i] * a + point.mean[i] * b;
+    }
+    into.ticks += point.ticks;
+}
+
+void Telemetry::clear() {
+    for (Level& level : levels) {
+        level.head = level.size = 0;
+        level.pushed = 0;
+        level.pending_count = 0;
+    }
+}
+
+void Telemetry::query(uint32_t ticks, std::vector<TelemetryPoint>& out) const {
+    out.clear();
+    const Level& finest = levels[0];
+    if (finest.size == 0) return;
+    const TelemetryPoint& newest = finest.points[(finest.head + capacity - 1) % capacity];
+    uint64_t end = uint64_t(newest.tick) + 1;
+
+    // A level reaches back to its oldest point; it has seen everything while
+    // it never wrapped
+    size_t chosen = levels.size() - 1;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const Level& level = levels[i];
+        if (level.size == 0) continue;
+        const TelemetryPoint& oldest = level.points[(level.head + capacity - level.size) % capacity];
+        bool complete = level.pushed <= capacity;
+        if (ticks == 0 ? complete : complete || end - oldest.tick >= ticks) {
+            chosen = i;
+            break;
+        }
+    }
+
+    const Level& level = levels[chosen];
+    uint64_t from = ticks == 0 || end < ticks ? 0 : end - ticks;
+    for (size_t i = 0; i < level.size; ++i) {
+        const TelemetryPoint& point = level.points[(level.head + capacity - level.size + i) % capacity];
+        if (point.tick + point.ticks > from) out.push_back(point);
+    }
+}
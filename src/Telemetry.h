@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-tick metrics recorded by Telemetry
+enum class Metric : int {
+    Photosynthetic,
+    Carnivorous,
+    MeanEnergy,
+    Births,
+    Deaths,
+    TickMicros, // Wall time of Field::tick
+    Count
+};
+constexpr int METRIC_COUNT = static_cast<int>(Metric::Count);
+
+// One chart point: the span of ticks starting at `tick` reduced to the
+// minimum, maximum and mean of every metric
+struct TelemetryPoint {
+    uint32_t tick = 0;
+    uint32_t ticks = 0; // Ticks covered
+    float min[METRIC_COUNT] = {};
+    float max[METRIC_COUNT] = {};
+    float mean[METRIC_COUNT] = {};
+};
+
+// Bounded history of per-tick metrics. Level 0 keeps the last `capacity`
+// ticks as they are; every `factor` points of a level are decimated into
+// one point of the next, so each level reaches `factor` times further back
+// at the same memory. Recording is a copy plus, on average, a fraction of
+// one merge per tick.
+class Telemetry {
+private:
+    struct Level {
+        std::vector<TelemetryPoint> points; // Ring
+        size_t head = 0;                    // Next slot to write
+        size_t size = 0;
+        uint64_t pushed = 0;                // Points ever written
+        TelemetryPoint pending;             // Partial point of the next level
+        int pending_count = 0;
+    };
+
+    std::vector<Level> levels;
+    size_t capacity;
+    int factor;
+
+    void push(size_t level, const TelemetryPoint& point);
+    static void merge(TelemetryPoint& into, const TelemetryPoint& point);
+
+public:
+    explicit Telemetry(size_t capacity = 1024, int factor = 4, int level_count = 12);
+
+    void record(uint32_t tick, const float values[METRIC_COUNT]);
+    void clear();
+    // Oldest-first points of the finest level reaching `ticks` back from the
+    // newest tick, or the finest level holding the whole history if `ticks`
+    // is 0. At most `capacity` points.
+    void query(uint32_t ticks, std::vector<TelemetryPoint>& out) const;
+};
@@ -0,0 +1,62 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(int threads) {
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_job() {
+    for (int i = next_index.fetch_add(1); i < job_size; i = next_index.fetch_add(1)) {
+        (*job)(i);
+    }
+}
+
+void ThreadPool::worker_loop() {
+    PROFILE_THREAD("worker");
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        lock.unlock();
+        run_job();
+        lock.lock();
+        if (++finished_workers == static_cast<int>(workers.size())) done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& body) {
+    if (count <= 0) return;
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) body(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        job_size = count;
+        next_index.store(0);
+        finished_workers = 0;
+        ++generation;
+    }
+    wake.notify_all();
+    run_job();
+    // Every worker checks in once per job, so none can still be inside it
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return finished_workers == static_cast<int>(workers.size()); });
+    job = nullptr;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fork-join loops. The calling thread takes
+// part in every parallel_for, so a pool of size 1 spawns no threads at all.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* job = nullptr;
+    int job_size = 0;
+    std::atomic<int> next_index{0};
+    int finished_workers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void worker_loop();
+    void run_job();
+
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+    // Calls body(i) for every i in [0, count) and returns when all are done
+    void parallel_for(int count, const std::function<void(int)>& body);
+};
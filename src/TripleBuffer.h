@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-writer / single-reader triple buffer. The writer fills
+// write_buffer() and publishes it; the reader calls update() and reads
+// read_buffer(), which always holds the newest complete publication.
+// Neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4; // Middle buffer not yet seen by the reader
+
+    T buffers[3];
+    std::atomic<uint8_t> middle{1};
+    uint8_t back = 0;  // Owned by the writer
+    uint8_t front = 2; // Owned by the reader
+
+public:
+    T& write_buffer() { return buffers[back]; }
+
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Swaps in the newest publication; returns false if there is none
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& read_buffer() const { return buffers[front]; }
+};
@@ -1,24 +1,32 @@
 #pragma once
 
-#include <SDL2/SDL.h>
-#include <random>
+#include <cstdint>
+#include "Random.h"
+
+enum class OrganismType : uint8_t {
+    Photosynthetic,
+    Carnivorous
+};
 
 struct Color {
-    Uint8 r, g, b;
-    Color(Uint8 r = 0, Uint8 g = 0, Uint8 b = 0) : r(r), g(g), b(b) {}
-    void randomize(std::mt19937& rng) {
-        std::uniform_int_distribution<Uint8> dist(0, 255);
-        r = dist(rng);
-        g = dist(rng);
-        b = dist(rng);
+    uint8_t r, g, b;
+    constexpr Color(uint8_t r = 0, uint8_t g = 0, uint8_t b = 0) : r(r), g(g), b(b) {}
+    void randomize(CounterRng& rng) {
+        uint32_t bits = rng.next_u32();
+        r = static_cast<uint8_t>(bits);
+        g = static_cast<uint8_t>(bits >> 8);
+        b = static_cast<uint8_t>(bits >> 16);
     }
 };
 
-constexpr int MUTATION_MARKERS_COUNT = 4;
-constexpr float MOVE_COST = 1.0f;
-constexpr float ATTACK_COST = 1.0f;
-constexpr float REPRODUCE_COST = 10.0f;
-constexpr float PHOTOSYNTHESIS_BASE_RATE = 0.5f;
-constexpr float MAX_ENERGY = 100.0f;
-constexpr int FERTILITY_DELAY = 100;
-constexpr float DENSITY_MUTATION_FACTOR = 0.0000001f; // Chance of mutation per neighbor
\ No newline at end of file
+constexpr Color PHOTOSYNTHETIC_COLOR(0, 255, 0); // Green
+constexpr Color CARNIVOROUS_COLOR(255, 0, 0);    // Red
+
+// Cells as drawn by the viewer, ARGB8888
+constexpr uint32_t BACKGROUND_PIXEL = 0xFFFFFFFFu; // White
+inline uint32_t to_pixel(const Color& color) {
+    return 0xFF000000u | (uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | color.b;
+}
+
+// Costs and rates are set per world, see Rules
+constexpr int MUTATION_MARKERS_COUNT = 4;
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "Vision.h"
+#include <algorithm>
+#include "Field.h"
+#include "ThreadPool.h"
+
+// Rows summed per job; the column pass splits on the same scale
+constexpr int VISION_ROWS_PER_JOB = 64;
+constexpr int VISION_COLUMNS_PER_JOB = 256;
+
+// counts[b][i]: set bits among bits 0..i of the byte b
+static const struct BytePrefix {
+    uint8_t counts[256][8];
+    BytePrefix() {
+        for (int b = 0; b < 256; ++b) {
+            int count = 0;
+            for (int i = 0; i < 8; ++i) {
+                count += (b >> i) & 1;
+                counts[b][i] = static_cast<uint8_t>(count);
+            }
+        }
+    }
+} BYTE_PREFIX;
+
+void VisionMap::reset(int new_width, int new_height, bool new_wrap) {
+    width = new_width;
+    height = new_height;
+    wrap = new_wrap;
+    occupied.clear();
+    carnivorous.clear();
+}
+
+void VisionMap::rebuild(const Field& field, ThreadPool* workers) {
+    const size_t entries = static_cast<size_t>(width + 1) * (height + 1);
+    if (occupied.size() != entries) {
+        occupied.assign(entries, 0);
+        carnivorous.assign(entries, 0);
+    }
+    // Prefix sums along each row, then down each column. Both passes split
+    // into independent jobs, and integer sums come out the same either way.
+    const int row_jobs = (height + VISION_ROWS_PER_JOB - 1) / VISION_ROWS_PER_JOB;
+    const int column_jobs = (width + VISION_COLUMNS_PER_JOB - 1) / VISION_COLUMNS_PER_JOB;
+    auto rows = [&](int i) {
+        sum_rows(field, i * VISION_ROWS_PER_JOB, std::min(height, (i + 1) * VISION_ROWS_PER_JOB));
+    };
+    auto columns = [&](int i) {
+        sum_columns(i * VISION_COLUMNS_PER_JOB, std::min(width, (i + 1) * VISION_COLUMNS_PER_JOB));
+    };
+    if (workers) {
+        workers->parallel_for(row_jobs, rows);
+        workers->parallel_for(column_jobs, columns);
+    } else {
+        for (int i = 0; i < row_jobs; ++i) rows(i);
+        for (int i = 0; i < column_jobs; ++i) columns(i);
+    }
+}
+
+void VisionMap::sum_rows(const Field& field, int y0, int y1) {
+    const Occupancy& occupancy = field.get_occupancy();
+    for (int y = y0; y < y1; ++y) {
+        const uint64_t* bits = occupancy.row_bits(y);
+        const uint64_t* carnivorous_bits = occupancy.carnivorous_row_bits(y);
+        uint32_t* occupied_row = &occupied[static_cast<size_t>(y + 1) * (width + 1)];
+        uint32_t* carnivorous_row = &carnivorous[static_cast<size_t>(y + 1) * (width + 1)];
+        uint32_t occupied_sum = 0, carnivorous_sum = 0;
+        for (int x0 = 0; x0 < width; x0 += 64) {
+            const int x1 = std::min(width, x0 + 64);
+            uint64_t word = bits[x0 >> 6];
+            if (!word) {
+                // Empty span: the sums carry straight across
+                std::fill(occupied_row + x0 + 1, occupied_row + x1 + 1, occupied_sum);
+                std::fill(carnivorous_row + x0 + 1, carnivorous_row + x1 + 1, carnivorous_sum);
+                continue;
+            }
+            uint64_t carnivores = carnivorous_bits[x0 >> 6];
+            if (x1 - x0 == 64) {
+                // A byte at a time from a table of running counts
+                for (int x = x0; x < x1; x += 8, word >>= 8, carnivores >>= 8) {
+                    const uint8_t* occupied_counts = BYTE_PREFIX.counts[word & 0xFF];
+                    const uint8_t* carnivorous_counts = BYTE_PREFIX.counts[carnivores & 0xFF];
+                    for (int i = 0; i < 8; ++i) {
+                        occupied_row[x + 1 + i] = occupied_sum + occupied_counts[i];
+                        carnivorous_row[x + 1 + i] = carnivorous_sum + carnivorous_counts[i];
+                    }
+                    occupied_sum += occupied_counts[7];
+                    carnivorous_sum += carnivorous_counts[7];
+                }
+                continue;
+            }
+            for (int x = x0; x < x1; ++x, word >>= 1, carnivores >>= 1) {
+                occupied_sum += static_cast<uint32_t>(word & 1);
+                carnivorous_sum += static_cast<uint32_t>(carnivores & 1);
+                occupied_row[x + 1] = occupied_sum;
+                carnivorous_row[x + 1] = carnivorous_sum;
+            }
+        }
+    }
+}
+
+void VisionMap::sum_columns(int x0, int x1) {
+    const size_t row = width + 1;
+    for (int y = 1; y < height; ++y) {
+        const size_t above = static_cast<size_t>(y) * row, here = above + row;
+        for (int x = x0 + 1; x <= x1; ++x) {
+            occupied[here + x] += occupied[above + x];
+            carnivorous[here + x] += carnivorous[above + x];
+        }
+    }
+}
+
+void VisionMap::add_rectangle(int x0, int y0, int x1, int y1, Sight& sight) const {
+    const size_t row = width + 1;
+    const size_t top = static_cast<size_t>(y0) * row, bottom = static_cast<size_t>(y1 + 1) * row;
+    auto sum = [&](const std::vector<uint32_t>& table) {
+        return table[bottom + x1 + 1] - table[top + x1 + 1] - table[bottom + x0] + table[top + x0];
+    };
+    uint32_t occupied_cells = sum(occupied);
+    uint32_t carnivorous_cells = sum(carnivorous);
+    sight.area += static_cast<uint32_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+    sight.carnivorous += carnivorous_cells;
+    sight.photosynthetic += occupied_cells - carnivorous_cells;
+}
+
+// Splits [a0, a1] into at most two spans inside [0, extent): clipped
+// without wrapping, cut at the seam with it. Returns the number of spans.
+static int split_span(int a0, int a1, int extent, bool wrap, int spans[2][2]) {
+    if (!wrap) {
+        a0 = std::max(a0, 0);
+        a1 = std::min(a1, extent - 1);
+        if (a0 > a1) return 0;
+        spans[0][0] = a0;
+        spans[0][1] = a1;
+        return 1;
+    }
+    if (a1 - a0 + 1 >= extent) {
+        spans[0][0] = 0;
+        spans[0][1] = extent - 1;
+        return 1;
+    }
+    const int length = a1 - a0 + 1;
+    a0 = ((a0 % extent) + extent) % extent;
+    a1 = a0 + length - 1;
+    spans[0][0] = a0;
+    spans[0][1] = std::min(a1, extent - 1);
+    if (a1 < extent) return 1;
+    spans[1][0] = 0;
+    spans[1][1] = a1 - extent;
+    return 2;
+}
+
+Sight VisionMap::look(int x0, int y0, int x1, int y1) const {
+    Sight sight;
+    int xs[2][2], ys[2][2];
+    int x_spans = split_span(x0, x1, width, wrap, xs);
+    int y_spans = split_span(y0, y1, height, wrap, ys);
+    for (int j = 0; j < y_spans; ++j) {
+        for (int i = 0; i < x_spans; ++i) {
+            add_rectangle(xs[i][0], ys[j][0], xs[i][1], ys[j][1], sight);
+        }
+    }
+    return sight;
+}
+
+Sight VisionMap::ahead(int x, int y, int direction, int radius) const {
+    switch (direction) {
+        case 0: return look(x - radius, y - radius, x + radius, y - 1);
+        case 1: return look(x + 1, y - radius, x + radius, y + radius);
+        case 2: return look(x - radius, y + 1, x + radius, y + radius);
+        default: return look(x - radius, y - radius, x - 1, y + radius);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Field;
+class ThreadPool;
+
+// Long-range sight comes in levels, see Evo; level L reaches 8 << L cells
+constexpr int VISION_LEVELS = 3;
+inline int vision_radius(int level) { return 8 << level; }
+
+// What an organism sees in a window of the world
+struct Sight {
+    uint32_t area = 0; // Cells inside the world
+    uint32_t photosynthetic = 0;
+    uint32_t carnivorous = 0;
+
+    uint32_t occupied() const { return photosynthetic + carnivorous; }
+    uint32_t free_cells() const { return area - occupied(); }
+};
+
+// Summed-area tables of the organisms of each type, rebuilt once per tick
+// from the grid as it stands before anyone acts. Any rectangle costs four
+// lookups per table whatever its size, so seeing 32 cells away is as cheap
+// as seeing 1. Queries during a tick see the start of the tick, the same
+// for every tile and thread count.
+class VisionMap {
+private:
+    // (width + 1) x (height + 1) entries each: entry (x, y) counts the cells
+    // left of x and above y. The first row and column stay 0.
+    std::vector<uint32_t> occupied;
+    std::vector<uint32_t> carnivorous;
+    int width = 0, height = 0;
+    bool wrap = false;
+
+    void sum_rows(const Field& field, int y0, int y1);
+    void sum_columns(int x0, int x1);
+    void add_rectangle(int x0, int y0, int x1, int y1, Sight& sight) const;
+
+public:
+    void reset(int width, int height, bool wrap);
+    void rebuild(const Field& field, ThreadPool* workers);
+    bool is_built() const { return !occupied.empty(); }
+
+    // Cells of [x0, x1] x [y0, y1], inclusive. Parts outside the world are
+    // left out, or wrapped around on a torus; a window never covers a cell
+    // twice, however large.
+    Sight look(int x0, int y0, int x1, int y1) const;
+    // The (2 radius + 1)^2 square centred on (x, y), the centre included
+    Sight around(int x, int y, int radius) const { return look(x - radius, y - radius, x + radius, y + radius); }
+    // The radius x (2 radius + 1) strip in front of (x, y) when facing
+    // `direction` (0: up, 1: right, 2: down, 3: left)
+    Sight ahead(int x, int y, int direction, int radius) const;
+};